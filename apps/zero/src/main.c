@@ -20,9 +20,9 @@ void main()
 {
 	LOG_INF("Zero APP (built " __DATE__ " " __TIME__ ")");
 
-	networking_init();
-	services_init();
-
+	/* The trip curve comes first, so that the OCP limit settles while the network comes up.
+	 * The default one is already set by the SIM if CONFIG_BCB_TRIP_CURVE_DEFAULT_FAST_RESTORE.
+	 */
 #ifdef CUSTOM_TRIP_SETTINGS
 	const bcb_tc_t *curve;
 	bcb_tc_pt_t curve_points[2];
@@ -47,6 +47,9 @@ void main()
 	bcb_set_tc(bcb_tc_get_default());
 #endif
 
+	networking_init();
+	services_init();
+
 	while (1) {
 		k_sleep(K_MSEC(1000));
 	}
@@ -531,7 +531,8 @@ static int adc_mcux_read_impl(struct device *dev, const adc_dma_sequence_config_
 	if (data->callback) {
 		EDMA_EnableChannelInterrupts(config->dma_base, config->dma_ch_result,
 					     kEDMA_MajorInterruptEnable);
-		if (edma_get_start_major_count(config->dma_base, config->dma_ch_result) > 50) {
+		if (edma_get_start_major_count(config->dma_base, config->dma_ch_result) >
+		    ADC_DMA_HALF_CALLBACK_MIN_SAMPLES) {
 			EDMA_EnableChannelInterrupts(config->dma_base, config->dma_ch_result,
 						     kEDMA_HalfInterruptEnable);
 		}
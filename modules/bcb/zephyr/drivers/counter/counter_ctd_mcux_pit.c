@@ -127,7 +127,11 @@ static int counter_ctd_mcux_pit_set_alarm(struct device *dev, uint8_t chan_id,
     struct counter_ctd_mcux_pit_data *data = dev->driver_data;
     data->alarm_data[chan_id].callback = cfg->callback;
     data->alarm_data[chan_id].user_data = cfg->user_data;
+    data->alarm_data[chan_id].dev = dev;
+    data->alarm_data[chan_id].chan_id = chan_id;
 
+    /* Discard a timeout that happened while the alarm was not set. */
+    PIT_ClearStatusFlags(config->base, chan_id, kPIT_TimerFlag);
     PIT_EnableInterrupts(config->base, chan_id, kPIT_TimerInterruptEnable);
 
     return 0;
@@ -1,6 +1,7 @@
 #define DT_DRV_COMPAT st_m95080
 
 #include <drivers/eeprom.h>
+#include <drivers/eeprom_m95080.h>
 #include <drivers/gpio.h>
 #include <drivers/spi.h>
 #include <zephyr.h>
@@ -29,6 +30,15 @@ LOG_MODULE_REGISTER(eeprom_m95080);
 #define EEPROM_M95080_STATUS_BP0	BIT(2) /* Block Protection 0 (RW) */
 #define EEPROM_M95080_STATUS_BP1	BIT(3) /* Block Protection 1 (RW) */
 
+/* Retry interval of the write-in-progress check and of a contended lock in async mode */
+#define EEPROM_M95080_ASYNC_RETRY	K_MSEC(1)
+
+struct eeprom_m95080_cache_entry {
+	off_t page;
+	uint32_t last_used;
+	bool is_valid;
+};
+
 struct eeprom_m95080_config {
 	const char *spi_dev_name;
 	const char *cs_dev_name;
@@ -44,6 +54,8 @@ struct eeprom_m95080_config {
 	uint8_t address_width;
 	uint16_t timeout;
 	bool readonly;
+	uint8_t *cache;
+	struct eeprom_m95080_cache_entry *cache_entries;
 };
 
 struct eeprom_m95080_data {
@@ -52,8 +64,20 @@ struct eeprom_m95080_data {
 	struct spi_cs_control spi_cs;
 	struct device *wp_dev;
 	struct k_mutex lock;
+	struct device *dev;
+	uint32_t cache_counter;
+	sys_slist_t async_queue;
+	struct k_delayed_work async_work;
+	size_t async_written;
+	size_t async_pending; /* Bytes in the write cycle, cached once it has completed */
+	int64_t async_timeout;
+	bool is_async_wip;
 };
 
+/* Asynchronous writes of all the instances; only the SPI transfers run in it. */
+static struct k_work_q eeprom_m95080_work_q;
+K_THREAD_STACK_DEFINE(eeprom_m95080_work_q_stack, CONFIG_EEPROM_M95080_WORK_Q_STACK_SIZE);
+
 static int eeprom_m95080_rdsr(const struct device *dev, uint8_t *status)
 {
 	struct eeprom_m95080_data *data = dev->driver_data;
@@ -182,7 +206,6 @@ static inline int eeprom_m95080_read_spi(const struct device *dev, off_t offset,
 	err = eeprom_m95080_wait_for_idle(dev);
 	if (err) {
 		LOG_ERR("EEPROM idle wait failed (err %d)", err);
-		k_mutex_unlock(&data->lock);
 		return err;
 	}
 
@@ -231,6 +254,7 @@ static inline size_t eeprom_m95080_limit_write_count(const struct device *dev, o
 	return count;
 }
 
+/* The device must be idle. */
 static inline int eeprom_m95080_write_spi(const struct device *dev, off_t offset, const void *buf,
 					  size_t len)
 {
@@ -269,12 +293,6 @@ static inline int eeprom_m95080_write_spi(const struct device *dev, off_t offset
 		__ASSERT(0, "invalid address width");
 	}
 
-	err = eeprom_m95080_wait_for_idle(dev);
-	if (err) {
-		LOG_ERR("EEPROM idle wait failed (err %d)", err);
-		return err;
-	}
-
 	err = eeprom_m95080_wren(dev);
 	if (err) {
 		LOG_ERR("failed to disable write protection (err %d)", err);
@@ -289,28 +307,108 @@ static inline int eeprom_m95080_write_spi(const struct device *dev, off_t offset
 	return count;
 }
 
-static int eeprom_m95080_read(struct device *dev, off_t offset, void *buf, size_t len)
+static uint8_t *eeprom_m95080_cache_get(const struct device *dev, off_t page)
 {
 	const struct eeprom_m95080_config *config = dev->config_info;
 	struct eeprom_m95080_data *data = dev->driver_data;
-	uint8_t *read_buf = buf;
+	int i;
+
+	for (i = 0; i < CONFIG_EEPROM_M95080_CACHE_PAGES; i++) {
+		if (config->cache_entries[i].is_valid && config->cache_entries[i].page == page) {
+			config->cache_entries[i].last_used = ++data->cache_counter;
+			return &config->cache[i * config->pagesize];
+		}
+	}
+
+	return NULL;
+}
+
+static uint8_t *eeprom_m95080_cache_fill(const struct device *dev, off_t page)
+{
+	const struct eeprom_m95080_config *config = dev->config_info;
+	struct eeprom_m95080_data *data = dev->driver_data;
+	struct eeprom_m95080_cache_entry *entry;
+	uint8_t *cache;
+	int lru = 0;
 	int ret;
+	int i;
 
-	if (!len) {
-		return 0;
+	if (!CONFIG_EEPROM_M95080_CACHE_PAGES) {
+		return NULL;
 	}
 
-	if ((offset + len) > config->size) {
-		LOG_WRN("attempt to read past device boundary");
-		return -EINVAL;
+	for (i = 1; i < CONFIG_EEPROM_M95080_CACHE_PAGES; i++) {
+		if (!config->cache_entries[i].is_valid ||
+		    config->cache_entries[i].last_used < config->cache_entries[lru].last_used) {
+			lru = i;
+		}
 	}
 
-	k_mutex_lock(&data->lock, K_FOREVER);
+	entry = &config->cache_entries[lru];
+	cache = &config->cache[lru * config->pagesize];
+	entry->is_valid = false;
+
+	ret = eeprom_m95080_read_spi(dev, page * config->pagesize, cache, config->pagesize);
+	if (ret < 0) {
+		return NULL;
+	}
+
+	entry->page = page;
+	entry->last_used = ++data->cache_counter;
+	entry->is_valid = true;
+
+	return cache;
+}
+
+/* Write-through; must be called with the lock held. */
+static void eeprom_m95080_cache_update(const struct device *dev, off_t offset, const void *buf,
+				       size_t len)
+{
+	const struct eeprom_m95080_config *config = dev->config_info;
+	uint8_t *cache;
+	off_t page;
+	off_t start;
+	off_t end;
+
+	for (page = offset / config->pagesize; page * config->pagesize < offset + len; page++) {
+		cache = eeprom_m95080_cache_get(dev, page);
+		if (!cache) {
+			continue;
+		}
+
+		start = MAX(offset, page * config->pagesize);
+		end = MIN(offset + len, (page + 1) * config->pagesize);
+		memcpy(&cache[start - page * config->pagesize],
+		       (const uint8_t *)buf + (start - offset), end - start);
+	}
+}
+
+/* Reads the memory array; must be called with the lock held. */
+/* Must be called with the lock held. */
+static void eeprom_m95080_cache_invalidate(const struct device *dev, off_t offset, size_t len)
+{
+	const struct eeprom_m95080_config *config = dev->config_info;
+	off_t page;
+	int i;
+
+	for (page = offset / config->pagesize; page * config->pagesize < offset + len; page++) {
+		for (i = 0; i < CONFIG_EEPROM_M95080_CACHE_PAGES; i++) {
+			if (config->cache_entries[i].page == page) {
+				config->cache_entries[i].is_valid = false;
+			}
+		}
+	}
+}
+
+static int eeprom_m95080_read_array(const struct device *dev, off_t offset, void *buf, size_t len)
+{
+	uint8_t *read_buf = buf;
+	int ret;
+
 	while (len) {
 		ret = eeprom_m95080_read_spi(dev, offset, read_buf, len);
 		if (ret < 0) {
 			LOG_ERR("failed to read EEPROM (err %d)", ret);
-			k_mutex_unlock(&data->lock);
 			return ret;
 		}
 
@@ -319,10 +417,74 @@ static int eeprom_m95080_read(struct device *dev, off_t offset, void *buf, size_
 		len -= ret;
 	}
 
-	k_mutex_unlock(&data->lock);
 	return 0;
 }
 
+static int eeprom_m95080_read(struct device *dev, off_t offset, void *buf, size_t len)
+{
+	const struct eeprom_m95080_config *config = dev->config_info;
+	struct eeprom_m95080_data *data = dev->driver_data;
+	int ret;
+
+	if (!len) {
+		return 0;
+	}
+
+	if ((offset + len) > config->size) {
+		LOG_WRN("attempt to read past device boundary");
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+
+	if (offset / config->pagesize == (offset + len - 1) / config->pagesize) {
+		/* Small reads of configuration blocks are served from the page cache. */
+		uint8_t *cache = eeprom_m95080_cache_get(dev, offset / config->pagesize);
+
+		if (!cache) {
+			cache = eeprom_m95080_cache_fill(dev, offset / config->pagesize);
+		}
+
+		if (cache) {
+			memcpy(buf, &cache[offset % config->pagesize], len);
+			k_mutex_unlock(&data->lock);
+			return 0;
+		}
+	}
+
+	ret = eeprom_m95080_read_array(dev, offset, buf, len);
+
+	k_mutex_unlock(&data->lock);
+	return ret;
+}
+
+int z_impl_eeprom_m95080_read_uncached(struct device *dev, off_t offset, void *buf, size_t len)
+{
+	const struct eeprom_m95080_config *config = dev->config_info;
+	struct eeprom_m95080_data *data = dev->driver_data;
+	int ret;
+
+	if (!len) {
+		return 0;
+	}
+
+	if ((offset + len) > config->size) {
+		LOG_WRN("attempt to read past device boundary");
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+
+	ret = eeprom_m95080_read_array(dev, offset, buf, len);
+	if (!ret) {
+		/* Cached pages follow what is in the memory array. */
+		eeprom_m95080_cache_update(dev, offset, buf, len);
+	}
+
+	k_mutex_unlock(&data->lock);
+	return ret;
+}
+
 static int eeprom_m95080_write(struct device *dev, off_t offset, const void *buf, size_t len)
 {
 	const struct eeprom_m95080_config *config = dev->config_info;
@@ -354,7 +516,13 @@ static int eeprom_m95080_write(struct device *dev, off_t offset, const void *buf
 	}
 
 	while (len) {
-		ret = eeprom_m95080_write_spi(dev, offset, pbuf, len);
+		ret = eeprom_m95080_wait_for_idle(dev);
+		if (ret) {
+			LOG_ERR("EEPROM idle wait failed (err %d)", ret);
+		} else {
+			ret = eeprom_m95080_write_spi(dev, offset, pbuf, len);
+		}
+
 		if (ret < 0) {
 			LOG_ERR("failed to write to EEPROM (err %d)", ret);
 			eeprom_m95080_write_enable(dev, false);
@@ -362,6 +530,7 @@ static int eeprom_m95080_write(struct device *dev, off_t offset, const void *buf
 			return ret;
 		}
 
+		eeprom_m95080_cache_update(dev, offset, pbuf, ret);
 		pbuf += ret;
 		offset += ret;
 		len -= ret;
@@ -377,6 +546,159 @@ static int eeprom_m95080_write(struct device *dev, off_t offset, const void *buf
 	return ret;
 }
 
+static void eeprom_m95080_async_complete(struct device *dev, int result)
+{
+	struct eeprom_m95080_data *data = dev->driver_data;
+	struct eeprom_m95080_request *req;
+	unsigned int key;
+	bool is_idle;
+
+	key = irq_lock();
+	req = SYS_SLIST_PEEK_HEAD_CONTAINER(&data->async_queue, req, node);
+	sys_slist_get_not_empty(&data->async_queue);
+	is_idle = sys_slist_is_empty(&data->async_queue);
+	irq_unlock(key);
+
+	if (result && data->async_pending) {
+		/* The page may or may not have been written. */
+		eeprom_m95080_cache_invalidate(dev, req->offset + data->async_written,
+					       data->async_pending);
+	}
+
+	data->async_written = 0;
+	data->async_pending = 0;
+	data->is_async_wip = false;
+
+	if (!is_idle) {
+		k_delayed_work_submit_to_queue(&eeprom_m95080_work_q, &data->async_work, K_NO_WAIT);
+	}
+
+	k_mutex_unlock(&data->lock);
+
+	if (req->callback) {
+		req->callback(dev, result, req->user_data);
+	}
+}
+
+/* Runs in the driver workqueue. Nothing here waits for the EEPROM; the write-in-progress bit is
+ * checked once the write cycle time has elapsed, and before each page, as a synchronous write may
+ * have left a write cycle in progress.
+ */
+static void eeprom_m95080_async_work(struct k_work *work)
+{
+	struct eeprom_m95080_data *data = CONTAINER_OF(work, struct eeprom_m95080_data, async_work);
+	struct device *dev = data->dev;
+	const struct eeprom_m95080_config *config = dev->config_info;
+	struct eeprom_m95080_request *req;
+	uint8_t status;
+	int ret;
+
+	if (k_mutex_lock(&data->lock, K_NO_WAIT)) {
+		/* A synchronous access is in progress. */
+		k_delayed_work_submit_to_queue(&eeprom_m95080_work_q, &data->async_work,
+					       EEPROM_M95080_ASYNC_RETRY);
+		return;
+	}
+
+	req = SYS_SLIST_PEEK_HEAD_CONTAINER(&data->async_queue, req, node);
+	if (!req) {
+		k_mutex_unlock(&data->lock);
+		return;
+	}
+
+	ret = eeprom_m95080_rdsr(dev, &status);
+	if (ret) {
+		LOG_ERR("Could not read status register (err %d)", ret);
+		eeprom_m95080_async_complete(dev, ret);
+		return;
+	}
+
+	if (status & EEPROM_M95080_STATUS_WIP) {
+		if (!data->is_async_wip) {
+			/* Left by a synchronous write. */
+			data->is_async_wip = true;
+			data->async_timeout = k_uptime_get() + config->timeout;
+		} else if (k_uptime_get() > data->async_timeout) {
+			eeprom_m95080_async_complete(dev, -EBUSY);
+			return;
+		}
+
+		k_delayed_work_submit_to_queue(&eeprom_m95080_work_q, &data->async_work,
+					       EEPROM_M95080_ASYNC_RETRY);
+		k_mutex_unlock(&data->lock);
+		return;
+	}
+
+	data->is_async_wip = false;
+
+	if (data->async_pending) {
+		/* Only what is in the memory array is cached. */
+		eeprom_m95080_cache_update(dev, req->offset + data->async_written,
+					   (const uint8_t *)req->buf + data->async_written,
+					   data->async_pending);
+		data->async_written += data->async_pending;
+		data->async_pending = 0;
+	}
+
+	if (data->async_written == req->len) {
+		eeprom_m95080_async_complete(dev, 0);
+		return;
+	}
+
+	/* Write protection is released only around each page, so that synchronous writes in
+	 * between cannot leave it in the wrong state.
+	 */
+	ret = eeprom_m95080_write_enable(dev, true);
+	if (!ret) {
+		ret = eeprom_m95080_write_spi(dev, req->offset + data->async_written,
+					      (const uint8_t *)req->buf + data->async_written,
+					      req->len - data->async_written);
+		eeprom_m95080_write_enable(dev, false);
+	}
+
+	if (ret < 0) {
+		LOG_ERR("failed to write to EEPROM (err %d)", ret);
+		eeprom_m95080_async_complete(dev, ret);
+		return;
+	}
+
+	data->async_pending = ret;
+	data->is_async_wip = true;
+	data->async_timeout = k_uptime_get() + 2 * config->timeout;
+	k_delayed_work_submit_to_queue(&eeprom_m95080_work_q, &data->async_work,
+				       K_MSEC(config->timeout));
+
+	k_mutex_unlock(&data->lock);
+}
+
+int z_impl_eeprom_m95080_write_async(struct device *dev, struct eeprom_m95080_request *req)
+{
+	const struct eeprom_m95080_config *config = dev->config_info;
+	struct eeprom_m95080_data *data = dev->driver_data;
+	unsigned int key;
+	bool is_idle;
+
+	if (config->readonly) {
+		LOG_WRN("attempt to write to read-only device");
+		return -EACCES;
+	}
+
+	if (!req->len || (req->offset + req->len) > config->size) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+	is_idle = sys_slist_is_empty(&data->async_queue);
+	sys_slist_append(&data->async_queue, &req->node);
+	irq_unlock(key);
+
+	if (is_idle) {
+		k_delayed_work_submit_to_queue(&eeprom_m95080_work_q, &data->async_work, K_NO_WAIT);
+	}
+
+	return 0;
+}
+
 static size_t eeprom_m95080_size(struct device *dev)
 {
 	const struct eeprom_m95080_config *config = dev->config_info;
@@ -387,8 +709,19 @@ static int eeprom_m95080_init(struct device *dev)
 {
 	const struct eeprom_m95080_config *config = dev->config_info;
 	struct eeprom_m95080_data *data = dev->driver_data;
+	static bool is_work_q_started;
+
+	if (!is_work_q_started) {
+		k_work_q_start(&eeprom_m95080_work_q, eeprom_m95080_work_q_stack,
+			       K_THREAD_STACK_SIZEOF(eeprom_m95080_work_q_stack),
+			       CONFIG_EEPROM_M95080_WORK_Q_PRIORITY);
+		is_work_q_started = true;
+	}
 
 	k_mutex_init(&data->lock);
+	data->dev = dev;
+	sys_slist_init(&data->async_queue);
+	k_delayed_work_init(&data->async_work, eeprom_m95080_async_work);
 
 	data->spi_dev = device_get_binding(config->spi_dev_name);
 	if (!data->spi_dev) {
@@ -443,6 +776,11 @@ static const struct eeprom_driver_api eeprom_m95080_api = {
 
 #define EEPROM_M95080_DEVICE(n)							\
 	static struct eeprom_m95080_data eeprom_m95080_##n##_data = {};		\
+	static uint8_t eeprom_m95080_##n##_cache[				\
+		CONFIG_EEPROM_M95080_CACHE_PAGES * DT_INST_PROP(n, pagesize)];	\
+	static struct eeprom_m95080_cache_entry					\
+		eeprom_m95080_##n##_cache_entries[				\
+			CONFIG_EEPROM_M95080_CACHE_PAGES];			\
 	static struct eeprom_m95080_config eeprom_m95080_##n##_config = {	\
 		.spi_dev_name = DT_INST_BUS_LABEL(n),				\
 		.frequency = DT_INST_PROP(n, spi_max_frequency),		\
@@ -452,6 +790,8 @@ static const struct eeprom_driver_api eeprom_m95080_api = {
 		.address_width = DT_INST_PROP(n, address_width),		\
 		.timeout = DT_INST_PROP(n, timeout),				\
 		.readonly = DT_INST_PROP(n, read_only),				\
+		.cache = eeprom_m95080_##n##_cache,				\
+		.cache_entries = eeprom_m95080_##n##_cache_entries,		\
 		IF_ENABLED(DT_INST_SPI_DEV_HAS_CS_GPIOS(n), (			\
 		.cs_dev_name = DT_INST_SPI_DEV_CS_GPIOS_LABEL(n),		\
 		.cs_pin  = DT_INST_SPI_DEV_CS_GPIOS_PIN(n),			\
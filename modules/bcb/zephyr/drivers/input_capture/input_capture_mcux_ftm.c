@@ -252,6 +252,18 @@ static uint32_t ic_mcux_ftm_get_value(struct device *dev, uint8_t channel)
 	return 0;
 }
 
+static uint32_t ic_mcux_ftm_get_edge_value(struct device *dev, uint8_t channel)
+{
+	const struct ic_mcux_ftm_config *config = dev->config_info;
+
+	if (channel >= config->channel_count) {
+		LOG_ERR("Invalid channel count");
+		return 0;
+	}
+
+	return config->base->CONTROLS[channel].CnV;
+}
+
 static uint32_t ic_mcux_ftm_get_frequency(struct device *dev)
 {
 	struct ic_mcux_ftm_data *data = dev->driver_data;
@@ -373,6 +385,7 @@ static const struct input_capture_driver_api ic_mcux_ftm_driver_api = {
 	.get_counter_maximum = ic_mcux_ftm_get_counter_maximum,
 	.set_callback = ic_mcux_ftm_set_callback,
 	.enable_interrupts = ic_mcux_ftm_enable_interrupts,
+	.get_edge_value = ic_mcux_ftm_get_edge_value,
 };
 
 #define TO_FTM_PRESCALE_DIVIDE(val) _DO_CONCAT(kFTM_Prescale_Divide_, val)
@@ -27,6 +27,12 @@ typedef enum adc_dma_perf_level {
 	ADC_DMA_PERF_LEVEL_5, /**< Level 5 - highest performance level, lowest DC accuracy. */
 } adc_dma_performance_level_t;
 
+/**
+ * The callback is also called when a half of the buffer is written, but only for sequences of
+ * more samples than this.
+ */
+#define ADC_DMA_HALF_CALLBACK_MIN_SAMPLES 50
+
 /**
  * @brief Fuction to be called when the samples were written to the buffer.
  * @param dev A pointer to the ADC device
@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @brief Header file for M95080 specific APIs of the EEPROM driver.
+ */
+
+#ifndef _ZEPHYR_INCLUDE_DRIVERS_EEPROM_M95080_H_
+#define _ZEPHYR_INCLUDE_DRIVERS_EEPROM_M95080_H_
+
+/**
+ * @ingroup io_interfaces
+ * @{
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/slist.h>
+#include <device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called when an asynchronous write has completed.
+ *
+ * @param[in] dev           A pointer to the device structure for the driver instance.
+ * @param[in] result        0 if successful, negative errno code otherwise.
+ * @param[in] user_data     User data given with the request.
+ */
+typedef void (*eeprom_m95080_callback_t)(struct device *dev, int result, void *user_data);
+
+/**
+ * @brief Asynchronous write request.
+ *
+ * Owned by the caller and must stay valid, together with the buffer, until the callback is called.
+ */
+struct eeprom_m95080_request {
+	sys_snode_t node; /**< Private */
+	off_t offset;
+	const void *buf;
+	size_t len;
+	eeprom_m95080_callback_t callback;
+	void *user_data;
+};
+
+/**
+ * @brief Queue a write to the EEPROM.
+ *
+ * Requests are written one page at a time in the workqueue of the driver, in the order they
+ * were queued. The caller is not blocked during the write cycles.
+ *
+ * @param[in] dev           A pointer to the device structure for the driver instance.
+ * @param[in] req           A pointer to the request.
+ * @retval 0 If the request was queued.
+ * @retval -EINVAL If the request is out of range.
+ * @retval -EACCES If the device is read-only.
+ */
+__syscall int eeprom_m95080_write_async(struct device *dev, struct eeprom_m95080_request *req);
+
+/**
+ * @brief Read from the memory array, bypassing the page cache.
+ *
+ * Meant for integrity checks, which would otherwise compare the cache with itself. The cached
+ * pages are updated with what has been read.
+ *
+ * @param[in] dev           A pointer to the device structure for the driver instance.
+ * @param[in] offset        Address offset to read from.
+ * @param[out] buf          Buffer to store the read data.
+ * @param[in] len           Number of bytes to read.
+ * @retval 0 If successful.
+ * @retval -EINVAL If the read is out of range.
+ */
+__syscall int eeprom_m95080_read_uncached(struct device *dev, off_t offset, void *buf,
+					  size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#include <syscalls/eeprom_m95080.h>
+
+#endif // _ZEPHYR_INCLUDE_DRIVERS_EEPROM_M95080_H_
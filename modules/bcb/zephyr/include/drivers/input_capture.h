@@ -27,6 +27,7 @@ typedef void (*input_capture_callback_t)(struct device *dev, uint8_t channel, ui
 typedef uint32_t (*input_capture_get_counter_t)(struct device *dev);
 typedef int (*input_capture_set_channel_t)(struct device *dev, uint8_t channel, uint8_t edge);
 typedef uint32_t (*input_capture_get_value_t)(struct device *dev, uint8_t channel);
+typedef uint32_t (*input_capture_get_edge_value_t)(struct device *dev, uint8_t channel);
 typedef uint32_t (*input_capture_get_frequency_t)(struct device *dev);
 typedef uint32_t (*input_capture_get_counter_maximum_t)(struct device *dev);
 typedef int (*input_capture_set_callback_t)(struct device *dev, uint8_t channel,
@@ -41,6 +42,7 @@ __subsystem struct input_capture_driver_api {
 	input_capture_get_counter_maximum_t get_counter_maximum;
 	input_capture_set_callback_t set_callback;
 	input_capture_enable_interrupts_t enable_interrupts;
+	input_capture_get_edge_value_t get_edge_value;
 };
 
 __syscall uint32_t input_capture_get_counter(struct device *dev);
@@ -71,6 +73,24 @@ static inline uint32_t z_impl_input_capture_get_value(struct device *dev, uint8_
 	return api->get_value(dev, channel);
 }
 
+/**
+ * @brief Get the counter value latched at the last edge of a channel.
+ *
+ * Unlike input_capture_get_value(), the values of dual-edge channel pairs are not combined.
+ * Returns 0 if the driver does not support this.
+ */
+__syscall uint32_t input_capture_get_edge_value(struct device *dev, uint8_t channel);
+static inline uint32_t z_impl_input_capture_get_edge_value(struct device *dev, uint8_t channel)
+{
+	struct input_capture_driver_api *api;
+
+	api = (struct input_capture_driver_api *)dev->driver_api;
+	if (api->get_edge_value) {
+		return api->get_edge_value(dev, channel);
+	}
+	return 0;
+}
+
 __syscall uint32_t input_capture_get_frequency(struct device *dev);
 static inline uint32_t z_impl_input_capture_get_frequency(struct device *dev)
 {
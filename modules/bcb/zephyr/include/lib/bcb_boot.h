@@ -0,0 +1,57 @@
+#ifndef _BCB_BOOT_H_
+#define _BCB_BOOT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Boot stages in the order they normally complete.
+ */
+typedef enum {
+	BCB_BOOT_STAGE_ETIME = 0, /**< Elapsed time timer started. */
+	BCB_BOOT_STAGE_TIMER,
+	BCB_BOOT_STAGE_CONFIG, /**< Configurations read from the EEPROM. */
+	BCB_BOOT_STAGE_ZD,
+	BCB_BOOT_STAGE_MSMNT,
+	BCB_BOOT_STAGE_SW,
+	BCB_BOOT_STAGE_BCB,
+	BCB_BOOT_STAGE_COAP,
+	BCB_BOOT_STAGE_SHELL,
+	BCB_BOOT_STAGE_TC, /**< Trip curve set up. */
+	BCB_BOOT_STAGE_CLOSED, /**< Switch closed for the first time. */
+	BCB_BOOT_STAGE_END,
+} bcb_boot_stage_t;
+
+/**
+ * Start the boot timeline. Must be called right after bcb_etime_init().
+ */
+int bcb_boot_init(void);
+
+/**
+ * Record the completion of a boot stage. Only the first call for each stage is recorded, hence
+ * this is cheap enough to be left in the normal code paths.
+ */
+void bcb_boot_mark(bcb_boot_stage_t stage);
+
+/**
+ * Get the time at which a stage completed.
+ *
+ * @param[in] stage Boot stage.
+ * @param[out] time Micro seconds since the kernel started.
+ * @return 0 on success, -ENOENT if the stage has not completed, -EINVAL if the stage is invalid.
+ */
+int bcb_boot_get_time(bcb_boot_stage_t stage, uint64_t *time);
+
+/**
+ * Get the name of a boot stage.
+ */
+const char *bcb_boot_get_stage_name(bcb_boot_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BCB_BOOT_H_
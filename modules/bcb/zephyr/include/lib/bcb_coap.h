@@ -4,12 +4,20 @@
 #include <stdint.h>
 #include <net/coap.h>
 #include <net/buf.h>
+#include <sys/slist.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct bcb_coap_timer {
+	uint32_t expiry; /* Uptime (ms) */
+	uint16_t index; /* Position in the timer heap */
+};
+
 struct bcb_coap_notifier {
+	sys_snode_t node; /* Address bucket or free list */
+	struct bcb_coap_timer timer; /* Next periodic notification */
 	struct coap_resource *resource;
 	struct coap_observer *observer;
 	uint32_t seq;
@@ -32,6 +40,8 @@ bool bcb_coap_has_pending(const struct sockaddr *addr);
 uint8_t *bcb_coap_response_buffer();
 struct coap_resource *bcb_coap_get_resource(const char *const *path);
 int bcb_coap_notify_async(struct coap_resource *resource);
+/* Changes whenever a new set of notifications is sent, so that they can share the payload. */
+uint32_t bcb_coap_get_notify_round(void);
 
 #ifdef __cplusplus
 }
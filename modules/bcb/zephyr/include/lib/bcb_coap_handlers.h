@@ -17,6 +17,12 @@ extern "C" {
 #define BCB_COAP_RESOURCE_CONFIG_ATTRIBUTES		((const char *const[]){ "ct=30001", NULL })
 #define BCB_COAP_RESOURCE_DEVICE_PATH			((const char *const[]){ "device", NULL })
 #define BCB_COAP_RESOURCE_DEVICE_ATTRIBUTES		((const char *const[]){ "ct=30001", NULL })
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+#define BCB_COAP_RESOURCE_STATS_PATH			((const char *const[]){ "stats", NULL })
+#define BCB_COAP_RESOURCE_STATS_ATTRIBUTES		((const char *const[]){ "ct=30001", NULL })
+#define BCB_COAP_RESOURCE_JOURNAL_PATH			((const char *const[]){ "journal", NULL })
+#define BCB_COAP_RESOURCE_JOURNAL_ATTRIBUTES		((const char *const[]){ "ct=30001", NULL })
+#endif
 #if 0
 #define BCB_COAP_RESOURCE_SWITCH_PATH			((const char *const[]){ "switch", NULL })
 #define BCB_COAP_RESOURCE_SWITCH_ATTRIBUTES		((const char *const[]){ NULL })
@@ -41,6 +47,12 @@ int bcb_coap_handlers_config_post(struct coap_resource *resource, struct coap_pa
 				  struct sockaddr *addr, socklen_t addr_len);
 int bcb_coap_handlers_device_post(struct coap_resource *resource, struct coap_packet *request,
 				  struct sockaddr *addr, socklen_t addr_len);
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+int bcb_coap_handlers_stats_post(struct coap_resource *resource, struct coap_packet *request,
+				 struct sockaddr *addr, socklen_t addr_len);
+int bcb_coap_handlers_journal_post(struct coap_resource *resource, struct coap_packet *request,
+				   struct sockaddr *addr, socklen_t addr_len);
+#endif
 #if 0
 int bcb_coap_handlers_switch_get(struct coap_resource *resource, struct coap_packet *request,
 				 struct sockaddr *addr, socklen_t addr_len);
@@ -4,8 +4,159 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+/**
+ * Records at fixed offsets. The offset and the maximum size of each one are set in Kconfig.
+ */
+typedef enum {
+	BCB_CONFIG_ID_IDENTITY = 0,
+	BCB_CONFIG_ID_MSMNT,
+	BCB_CONFIG_ID_TC_DEF,
+	BCB_CONFIG_ID_TC_DEF_MSM,
+	BCB_CONFIG_ID_TC_DEF_CSOM_MOD,
+	BCB_CONFIG_ID_TC_DEF_CSOM_SD,
+	BCB_CONFIG_ID_END,
+} bcb_config_id_t;
+
+/**
+ * Records kept in the log-structured part of the EEPROM. Frequently written records go here so
+ * that the writes are spread over the log instead of a single page.
+ */
+typedef enum {
+	BCB_CONFIG_LOG_ID_BCB = 0,
+	BCB_CONFIG_LOG_ID_TC_DEF_OCPT,
+	BCB_CONFIG_LOG_ID_TC_DEF_SNAPSHOT,
+	BCB_CONFIG_LOG_ID_END,
+} bcb_config_log_id_t;
+
+/**
+ * Statistics of the EEPROM integrity checks.
+ */
+typedef struct bcb_config_scrub_stats {
+	uint32_t runs; /**< Number of checks. */
+	uint32_t errors; /**< Corrupted pages, records and copies found. */
+	uint32_t repairs; /**< Errors that have been repaired. */
+	uint32_t failures; /**< Errors that could not be repaired. */
+} bcb_config_scrub_stats_t;
+
+/* Size of the header stored in front of each fixed offset record. */
+#define BCB_CONFIG_HEADER_SIZE		8
+
+/**
+ * Check at compile time that a record of the given size fits in its Kconfig area.
+ */
+#define BCB_CONFIG_ASSERT_SIZE(name, size)                                                         \
+	BUILD_ASSERT((size) + BCB_CONFIG_HEADER_SIZE <=                                            \
+			     CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_##name,                         \
+		     "Record does not fit in CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_" #name)
+
+/* Size of the header stored in front of each log-structured record. */
+#define BCB_CONFIG_LOG_HEADER_SIZE	10
+
+/* Largest size of each log-structured record. All of them must fit in a bank of the log. */
+#define BCB_CONFIG_LOG_SIZE_BCB		5
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT
+#define BCB_CONFIG_LOG_SIZE_TC_DEF_OCPT	(6 + 7 * CONFIG_BCB_TRIP_CURVE_DEFAULT_OCPT_LOG_SIZE)
+#define BCB_CONFIG_LOG_SIZE_TC_DEF_SNAPSHOT (2 + 2 * CONFIG_BCB_TRIP_CURVE_DEFAULT_MAX_POINTS)
+#else
+#define BCB_CONFIG_LOG_SIZE_TC_DEF_OCPT	0
+#define BCB_CONFIG_LOG_SIZE_TC_DEF_SNAPSHOT 0
+#endif
+
+/**
+ * Check at compile time that a log-structured record is within the size it is accounted for.
+ */
+#define BCB_CONFIG_LOG_ASSERT_SIZE(name, size)                                                     \
+	BUILD_ASSERT((size) <= BCB_CONFIG_LOG_SIZE_##name &&                                       \
+			     (size) <= CONFIG_BCB_LIB_PERSISTENT_CONFIG_LOG_RECORD_MAX,            \
+		     "Record is larger than BCB_CONFIG_LOG_SIZE_" #name)
+
+/* Size of a slot of the event journal area. */
+#define BCB_CONFIG_JOURNAL_SLOT_SIZE	16
+#define BCB_CONFIG_JOURNAL_SLOTS                                                                   \
+	(CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_JOURNAL / BCB_CONFIG_JOURNAL_SLOT_SIZE)
+
+/**
+ * @brief Converts a record written by an older firmware.
+ *
+ * Versions start at 1; records written before versioning was introduced are reported as
+ * version 0.
+ *
+ * @param version Version of the stored record.
+ * @param stored Stored record.
+ * @param stored_size Size of the stored record.
+ * @param data Current record, holding the values given to the load function.
+ * @param size Size of the current record.
+ * @return 0 on success, a negative error code to discard the stored record.
+ */
+typedef int (*bcb_config_migrate_t)(uint8_t version, const uint8_t *stored, size_t stored_size,
+				    uint8_t *data, size_t size);
+
 int bcb_config_init(void);
-int bcb_config_load(off_t offset, uint8_t *data, size_t size);
-int bcb_config_store(off_t offset, uint8_t *data, size_t size);
+
+/**
+ * Load a record. A corrupted record is restored from its redundant copy, if it has one.
+ * A record of an older version is converted by @p migrate and written back in the
+ * current version. Without a migration function, fields are expected to be only appended:
+ * the stored part is copied over @p data and the remaining fields keep their given values.
+ *
+ * @return 0 on success, -EINVAL if there is no valid record, -ENOTSUP if the record is newer
+ *	   than @p version. @p data is not modified on failure.
+ */
+int bcb_config_load(bcb_config_id_t id, uint8_t version, uint8_t *data, size_t size,
+		    bcb_config_migrate_t migrate);
+
+/**
+ * Store a record. Only the RAM cache is updated; the EEPROM is written by a low priority thread
+ * once no further updates arrive within the flush delay.
+ */
+int bcb_config_store(bcb_config_id_t id, uint8_t version, uint8_t *data, size_t size);
+
+/**
+ * Load the latest valid copy of a log record. Older versions are handled as in
+ * bcb_config_load().
+ * @return 0 on success, -ENOENT if the record has never been stored, -EINVAL if it is invalid,
+ *	   -ENOTSUP if it is newer than @p version.
+ */
+int bcb_config_log_load(bcb_config_log_id_t id, uint8_t version, uint8_t *data, size_t size,
+			bcb_config_migrate_t migrate);
+
+/**
+ * Append a new copy of a log record. Like bcb_config_store(), the write is deferred. The
+ * previous copy remains valid until this one is completely written.
+ */
+int bcb_config_log_store(bcb_config_log_id_t id, uint8_t version, uint8_t *data, size_t size);
+
+/**
+ * Load a slot of the event journal area from the cache. Slots have no header; checking them is
+ * up to the caller.
+ * @param[out] data BCB_CONFIG_JOURNAL_SLOT_SIZE bytes.
+ * @return 0 on success, -EINVAL if the slot is out of range.
+ */
+int bcb_config_journal_load(uint8_t slot, uint8_t *data);
+
+/**
+ * Store a slot of the event journal area. Each slot is written on its own, so an event costs the
+ * write of one page instead of an append to the log. Like bcb_config_store(), the write is
+ * deferred.
+ * @param[in] data BCB_CONFIG_JOURNAL_SLOT_SIZE bytes.
+ * @return 0 on success, -EINVAL if the slot is out of range.
+ */
+int bcb_config_journal_store(uint8_t slot, const uint8_t *data);
+
+/**
+ * Write all pending updates to the EEPROM before returning.
+ */
+int bcb_config_sync(void);
+
+/**
+ * Check the integrity of the EEPROM now and repair what can be repaired. This is also done
+ * periodically in the background.
+ */
+int bcb_config_scrub(void);
+
+/**
+ * Get the statistics of the EEPROM integrity checks.
+ */
+void bcb_config_get_scrub_stats(bcb_config_scrub_stats_t *stats);
 
 #endif // _BCB_CONFIG_H_
\ No newline at end of file
@@ -20,9 +20,29 @@ extern "C" {
 #endif
 
 int bcb_etime_init(void);
+
+/**
+ * Get the elapsed time in ticks. This is the common timestamp for switch events, zero-crossings
+ * and measurement frames. It is monotonic and safe to call from interrupt context.
+ */
 uint64_t bcb_etime_get_now();
 uint32_t bcb_etime_get_frequency();
 
+/**
+ * Convert elapsed time ticks to nano seconds.
+ */
+uint64_t bcb_etime_to_ns(uint64_t ticks);
+
+/**
+ * Convert nano seconds to elapsed time ticks.
+ */
+uint64_t bcb_etime_from_ns(uint64_t ns);
+
+/**
+ * Convert micro seconds to elapsed time ticks.
+ */
+uint64_t bcb_etime_from_us(uint64_t us);
+
 #ifdef __cplusplus
 }
 #endif
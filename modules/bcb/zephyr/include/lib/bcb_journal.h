@@ -0,0 +1,83 @@
+#ifndef _BCB_JOURNAL_H_
+#define _BCB_JOURNAL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Flag in the argument of a passed OCP self-test. */
+#define BCB_JOURNAL_ARG_PASSED 0x80
+
+/**
+ * Types of the journal events. The meaning of the argument and the value depends on the type.
+ */
+typedef enum {
+	BCB_JOURNAL_TYPE_BOOT = 0, /**< Argument: RCM_SRS0, value: RCM_SRS1 (reset sources). */
+	BCB_JOURNAL_TYPE_TRIP, /**< Argument: bcb_tc_cause_t, value: see bcb_journal_add_trip(). */
+	BCB_JOURNAL_TYPE_RECOVERY, /**< Re-closing after a trip, same as BCB_JOURNAL_TYPE_TRIP. */
+	BCB_JOURNAL_TYPE_OCP_TEST, /**< Argument: bcb_ocp_direction_t | BCB_JOURNAL_ARG_PASSED,
+					value: duration (ns), -1 if the switch did not open. */
+	BCB_JOURNAL_TYPE_CONFIG, /**< Argument: bcb_config_id_t, value: version. */
+	BCB_JOURNAL_TYPE_END
+} bcb_journal_type_t;
+
+/**
+ * A structure representing a journal event.
+ */
+typedef struct bcb_journal_event {
+	uint32_t seq; /**< Sequence number, never reused. The first event is 1. */
+	uint32_t uptime; /**< Time since the boot the event was recorded in (ms). */
+	bcb_journal_type_t type;
+	uint8_t arg;
+	int32_t value;
+} bcb_journal_event_t;
+
+/**
+ * Restore the journal and record the boot. Must be called after bcb_config_init().
+ */
+int bcb_journal_init(void);
+
+/**
+ * Record an event. Events recorded before bcb_journal_init() are dropped.
+ * Can be called from an ISR; the journal is stored later in the system workqueue.
+ */
+void bcb_journal_add(bcb_journal_type_t type, uint8_t arg, int32_t value);
+
+/**
+ * Record a trip or a recovery. The value is the temperature of the power stage input (C) for
+ * over temperature trips, and the RMS current (mA) otherwise.
+ * @param[in] type BCB_JOURNAL_TYPE_TRIP or BCB_JOURNAL_TYPE_RECOVERY.
+ * @param[in] cause Trip cause (bcb_tc_cause_t).
+ */
+void bcb_journal_add_trip(bcb_journal_type_t type, uint8_t cause);
+
+/**
+ * Get the range of sequence numbers of the retained events. Not all the events in the range are
+ * retained.
+ * @param[out] first Sequence number of the oldest event.
+ * @param[out] last Sequence number of the latest event.
+ * @return 0 on success, -ENOENT if the journal is empty.
+ */
+int bcb_journal_get_range(uint32_t *first, uint32_t *last);
+
+/**
+ * Get the oldest retained event after a sequence number. Trips and recoveries are retained apart
+ * from the other events, hence the retained sequence numbers may have gaps.
+ * @param[in] after Sequence number, 0 to get the oldest event.
+ * @param[out] event A pointer to the event structure.
+ * @return 0 on success, -ENOENT if no later event is retained.
+ */
+int bcb_journal_get_next(uint32_t after, bcb_journal_event_t *event);
+
+/**
+ * Get the name of an event type.
+ */
+const char *bcb_journal_get_type_name(bcb_journal_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_JOURNAL_H_ */
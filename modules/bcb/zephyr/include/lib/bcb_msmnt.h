@@ -2,6 +2,7 @@
 #define _BCB_MSMNT_H_
 
 #include <stdint.h>
+#include <sys/slist.h>
 #include "bcb_common.h"
 
 #ifdef __cplusplus
@@ -23,11 +24,53 @@ typedef enum {
 	BCB_MSMNT_TYPE_V_REF_1V5
 } bcb_msmnt_type_t;
 
+/**
+ * @brief Consecutive sample frames of the fast (current and voltage) channels.
+ */
+typedef struct bcb_msmnt_frames {
+	const volatile uint16_t *buffer; /**< Interleaved raw ADC samples. */
+	uint32_t count; /**< Number of frames in the buffer. */
+	uint8_t stride; /**< Number of samples in a frame. */
+	uint32_t interval; /**< Time between two frames in elapsed time ticks. */
+	uint64_t etime; /**< Approximate elapsed time of the last frame. */
+} bcb_msmnt_frames_t;
+
+typedef void (*bcb_msmnt_frames_handler_t)(const bcb_msmnt_frames_t *frames);
+
+/**
+ * @brief Callback for processing the sample stream of the fast channels.
+ *
+ * The handler is called from the DMA interrupt whenever a half of the sample buffer is filled.
+ */
+struct bcb_msmnt_frames_callback {
+	sys_snode_t node;
+	bcb_msmnt_frames_handler_t handler;
+};
+
+struct bcb_msmnt_window;
+
+typedef void (*bcb_msmnt_window_handler_t)(struct bcb_msmnt_window *window, uint16_t raw);
+
+/**
+ * @brief Window comparison of a slow (ADC1) channel.
+ *
+ * The handler is called from the DMA interrupt after each conversion sequence of ADC1 while the
+ * raw value of the channel is outside [low, high].
+ */
+struct bcb_msmnt_window {
+	sys_snode_t node;
+	bcb_msmnt_type_t type;
+	uint16_t low;
+	uint16_t high;
+	bcb_msmnt_window_handler_t handler;
+};
+
 int bcb_msmnt_init(void);
 int bcb_msmnt_config_load(void);
 int bcb_msmnt_config_store(void);
 
 int32_t bcb_msmnt_get_temp(bcb_temp_sensor_t sensor);
+uint16_t bcb_msmnt_temp_to_raw(bcb_temp_sensor_t sensor, int32_t temp);
 int32_t bcb_msmnt_get_voltage(void);
 int32_t bcb_msmnt_get_current(void);
 int32_t bcb_msmnt_get_current_low_gain(void);
@@ -41,6 +84,12 @@ int bcb_msmnt_set_calib_param_b(bcb_msmnt_type_t type, uint16_t b);
 int bcb_msmnt_get_calib_param_a(bcb_msmnt_type_t type, uint16_t *a);
 int bcb_msmnt_get_calib_param_b(bcb_msmnt_type_t type, uint16_t *b);
 
+int bcb_msmnt_get_frame_index(bcb_msmnt_type_t type);
+int bcb_msmnt_add_frames_callback(struct bcb_msmnt_frames_callback *callback);
+void bcb_msmnt_remove_frames_callback(struct bcb_msmnt_frames_callback *callback);
+int bcb_msmnt_add_window(struct bcb_msmnt_window *window);
+void bcb_msmnt_remove_window(struct bcb_msmnt_window *window);
+
 int bcb_msmnt_start(void);
 int bcb_msmnt_stop(void);
 void bcb_msmnt_rms_start(uint8_t interval);
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <sys/slist.h>
+#include <lib/bcb_zd.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,16 +30,45 @@ typedef struct bcb_sw_callback {
 	bcb_sw_callback_handler_t handler;
 } bcb_sw_callback_t;
 
+typedef void (*bcb_ocp_callback_handler_t)(uint8_t current);
+
+typedef struct bcb_ocp_callback {
+	sys_snode_t node;
+	bcb_ocp_callback_handler_t handler;
+} bcb_ocp_callback_t;
+
 int bcb_sw_init(void);
 int bcb_sw_on(void);
 int bcb_sw_off(void);
 bool bcb_sw_is_on();
+/**
+ * @brief Close the switch at the next predicted voltage or current zero-crossing.
+ *
+ * The switch is closed immediately if the zero-crossing cannot be predicted.
+ */
+int bcb_sw_on_at_zd(bcb_zd_type_t type);
+/**
+ * @brief Open the switch at the next predicted voltage or current zero-crossing.
+ *
+ * The switch is opened immediately if the zero-crossing cannot be predicted.
+ */
+int bcb_sw_off_at_zd(bcb_zd_type_t type);
+void bcb_sw_cancel_scheduled(void);
 uint32_t bcb_sw_get_on_off_duration(void);
 bcb_sw_cause_t bcb_sw_get_cause(void);
 int bcb_sw_add_callback(bcb_sw_callback_t *callback);
 void bcb_sw_remove_callback(bcb_sw_callback_t *callback);
 
+/**
+ * @brief Set the hardware OCP limit without waiting for it to settle.
+ *
+ * Closing the switch is deferred while the new limit is settling. OCP callbacks are called
+ * from the system workqueue once the limit has taken effect.
+ */
 int bcb_ocp_set_limit(uint8_t current);
+bool bcb_ocp_is_limit_settling(void);
+int bcb_ocp_add_callback(bcb_ocp_callback_t *callback);
+void bcb_ocp_remove_callback(bcb_ocp_callback_t *callback);
 int bcb_ocp_test_trigger(bcb_ocp_direction_t direction, bool enable);
 bcb_ocp_direction_t bcb_ocp_test_get_direction(void);
 uint32_t bcb_ocp_test_get_duration(void);
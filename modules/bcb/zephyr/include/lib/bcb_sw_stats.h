@@ -0,0 +1,62 @@
+#ifndef _BCB_SW_STATS_H_
+#define _BCB_SW_STATS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bucket i holds durations in [2^(i + 8), 2^(i + 9)) ns. The first bucket also holds
+ * durations below 256 ns.
+ */
+#define BCB_SW_STATS_BUCKETS 24
+
+typedef enum {
+	BCB_SW_STATS_ON_OFF_EXT = 0, /**< On to off, opened by a command. */
+	BCB_SW_STATS_ON_OFF_OCP, /**< On to off, opened by the hardware OCP. */
+	BCB_SW_STATS_ON_OFF_OTP, /**< On to off, opened by the OTP. */
+	BCB_SW_STATS_ON_OFF_UVP, /**< On to off, opened by the UVP. */
+	BCB_SW_STATS_OCP_TEST, /**< OCP test trigger to open. */
+	BCB_SW_STATS_CLOSE, /**< Close command to conduction. */
+	BCB_SW_STATS_END,
+} bcb_sw_stats_type_t;
+
+/**
+ * A structure representing a latency histogram. All durations are in nanoseconds.
+ */
+typedef struct bcb_sw_stats {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint32_t mean;
+	uint32_t p99; /**< Upper limit of the bucket holding the 99th percentile. */
+	uint32_t buckets[BCB_SW_STATS_BUCKETS];
+} bcb_sw_stats_t;
+
+/**
+ * Add a sample to a histogram.
+ */
+void bcb_sw_stats_add(bcb_sw_stats_type_t type, uint32_t duration);
+
+/**
+ * Get a copy of a histogram.
+ * @return 0 on success, -EINVAL if the type is invalid.
+ */
+int bcb_sw_stats_get(bcb_sw_stats_type_t type, bcb_sw_stats_t *stats);
+
+/**
+ * Clear all histograms.
+ */
+void bcb_sw_stats_reset(void);
+
+/**
+ * Get the upper limit (exclusive) of a bucket in nanoseconds.
+ */
+uint32_t bcb_sw_stats_get_bucket_limit(uint8_t bucket);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_SW_STATS_H_ */
@@ -0,0 +1,69 @@
+#ifndef _BCB_TBASE_H_
+#define _BCB_TBASE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Fixed-point ratio between two time bases. Converting with it takes 32-bit multiplies and shifts,
+ * which avoids the software 64-bit division in interrupt handlers.
+ */
+typedef struct bcb_tbase {
+	uint64_t mult; /**< Ratio scaled by 2^shift, with the most significant bit set. */
+	uint8_t shift; /**< Number of fractional bits, 32 to 95. */
+} bcb_tbase_t;
+
+/**
+ * Compute the ratio to convert ticks of one time base to the other.
+ *
+ * @param[out] tbase A pointer to the ratio.
+ * @param[in] from Frequency of the source time base in Hz.
+ * @param[in] to Frequency of the target time base in Hz.
+ * @return 0 on success, -EINVAL if a frequency is zero.
+ */
+int bcb_tbase_init(bcb_tbase_t *tbase, uint32_t from, uint32_t to);
+
+/**
+ * Convert ticks with a ratio computed by bcb_tbase_init(). The result is rounded to the nearest
+ * tick of the target time base. The ratio has 64 significant bits, so the error before the
+ * rounding is less than 2^-64 of the result and exact halves may round either way. Results above
+ * UINT64_MAX are truncated.
+ */
+static inline uint64_t bcb_tbase_convert(const bcb_tbase_t *tbase, uint64_t ticks)
+{
+	uint32_t t_lo = (uint32_t)ticks;
+	uint32_t t_hi = (uint32_t)(ticks >> 32);
+	uint32_t m_lo = (uint32_t)tbase->mult;
+	uint32_t m_hi = (uint32_t)(tbase->mult >> 32);
+	uint64_t ll = (uint64_t)t_lo * m_lo;
+	uint64_t lh = (uint64_t)t_lo * m_hi;
+	uint64_t hl = (uint64_t)t_hi * m_lo;
+	uint64_t mid;
+	uint64_t lo;
+	uint64_t hi;
+
+	/* 128-bit product from 32x32 partial products, which are single instructions. */
+	mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+	lo = (mid << 32) | (uint32_t)ll;
+	hi = (uint64_t)t_hi * m_hi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+	if (tbase->shift <= 64) {
+		uint64_t round = (uint64_t)1 << (tbase->shift - 1);
+
+		lo += round;
+		hi += lo < round;
+		return tbase->shift == 64 ? hi : (hi << (64 - tbase->shift)) | (lo >> tbase->shift);
+	}
+
+	hi += (uint64_t)1 << (tbase->shift - 65);
+	return hi >> (tbase->shift - 64);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_TBASE_H_ */
@@ -0,0 +1,50 @@
+#ifndef _BCB_TC_DEF_CSOM_SD_H_
+#define _BCB_TC_DEF_CSOM_SD_H_
+
+#include <lib/bcb_tc_def_msm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bcb_tc_def_csom_sd_config {
+	uint16_t zdc_closed; /**< Number of half-cycles the switch stays closed within the period. */
+	uint16_t zdc_period; /**< Total number of half-cycles considered as the period. */
+} bcb_tc_def_csom_sd_config_t;
+
+/**
+ * Initialises the sigma-delta modulation control state machine.
+ */
+int bcb_tc_def_csom_sd_init(void);
+
+/**
+ * Set the configuration of the sigma-delta modulation control state machine.
+ * The duty cycle (zdc_closed / zdc_period) is applied by distributing the closed half-cycles
+ * evenly over the period using a first-order sigma-delta accumulator.
+ * @param[in] config A pointer to the configuration structure.
+ */
+int bcb_tc_def_csom_sd_config_set(bcb_tc_def_csom_sd_config_t *config);
+
+/**
+ * Get the configuration of the sigma-delta modulation control state machine.
+ * @param[out] config A pointer to the configuration structure.
+ */
+int bcb_tc_def_csom_sd_config_get(bcb_tc_def_csom_sd_config_t *config);
+
+/**
+ * Feeds an event to the sigma-delta modulation control state machine.
+ * @param[in] event The event.
+ * @param[in] arg Argument for the event.
+ */
+int bcb_tc_def_csom_sd_event(bcb_tc_def_event_t event, void *arg);
+
+/**
+ * Clean up the sigma-delta modulation control state machine.
+ */
+void bcb_tc_def_csom_sd_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_TC_DEF_CSOM_SD_H_ */
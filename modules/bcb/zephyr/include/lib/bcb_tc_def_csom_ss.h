@@ -0,0 +1,38 @@
+#ifndef _BCB_TC_DEF_CSOM_SS_H_
+#define _BCB_TC_DEF_CSOM_SS_H_
+
+#include <lib/bcb_tc_def_msm.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initialises the soft-start state machine.
+ */
+int bcb_tc_def_csom_ss_init(void);
+
+/**
+ * Feeds an event to the soft-start state machine.
+ * @param[in] event The event.
+ * @param[in] arg Argument for the event.
+ */
+int bcb_tc_def_csom_ss_event(bcb_tc_def_event_t event, void *arg);
+
+/**
+ * Check whether the soft-start ramp has been completed.
+ * @return true if the switch has been fully conducting since the last step of the ramp.
+ */
+bool bcb_tc_def_csom_ss_is_done(void);
+
+/**
+ * Clean up the soft-start state machine. The ramp restarts with the next event.
+ */
+void bcb_tc_def_csom_ss_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_TC_DEF_CSOM_SS_H_ */
@@ -54,10 +54,31 @@ typedef enum {
 typedef enum {
 	BCB_TC_DEF_MSM_CSOM_NONE = 0, /**< No operation mode. */
 	BCB_TC_DEF_MSM_CSOM_MOD, /**< Modulation control operation mode. */
+	BCB_TC_DEF_MSM_CSOM_SD, /**< Sigma-delta modulation control operation mode. */
+	BCB_TC_DEF_MSM_CSOM_SS, /**< Soft-start operation mode (internal, cannot be configured). */
 	BCB_TC_DEF_MSM_CSOM_END
 
 } bcb_tc_def_msm_csom_t;
 
+/**
+ * The enumeration of recovery policies for the main state machine.
+ */
+typedef enum {
+	BCB_TC_DEF_MSM_REC_POLICY_FIXED = 0, /**< Fixed delay between recovery attempts. */
+	BCB_TC_DEF_MSM_REC_POLICY_BACKOFF, /**< Exponential back-off with jitter and budget. */
+	BCB_TC_DEF_MSM_REC_POLICY_END
+} bcb_tc_def_msm_rec_policy_t;
+
+/**
+ * The enumeration of supply types detected by the main state machine.
+ */
+typedef enum {
+	BCB_TC_DEF_MSM_SUPPLY_UNKNOWN = 0,
+	BCB_TC_DEF_MSM_SUPPLY_DC,
+	BCB_TC_DEF_MSM_SUPPLY_AC,
+	BCB_TC_DEF_MSM_SUPPLY_END
+} bcb_tc_def_msm_supply_t;
+
 /**
  * A structure representing the configuration of the main state machine.
  */
@@ -67,6 +88,7 @@ typedef struct bcb_msm_config {
 	uint16_t rec_attempts; /**< Number of recovery attempts. */
 	uint32_t rec_delay; /**< Recovery delay in microseconds. */
 	uint32_t rec_reset_timeout; /**< Recovery reset timeout in milliseconds. */
+	bcb_tc_def_msm_rec_policy_t rec_policy; /**< Recovery policy. */
 
 } bcb_tc_def_msm_config_t;
 
@@ -107,6 +129,20 @@ bcb_tc_def_msm_state_t bcb_tc_def_msm_get_state(void);
  */
 bcb_tc_def_msm_cause_t bcb_tc_def_msm_get_cause(void);
 
+/**
+ * Set the supply type expected by the next close command, i.e. the one detected before a power
+ * loss. Supply detection then ends as soon as that supply type is confirmed. The hint is dropped
+ * by the next open or close command.
+ * @param[in] supply The expected supply type.
+ */
+void bcb_tc_def_msm_set_supply_hint(bcb_tc_def_msm_supply_t supply);
+
+/**
+ * Get the supply type detected when the switch was last closed.
+ * @return The supply type.
+ */
+bcb_tc_def_msm_supply_t bcb_tc_def_msm_get_supply(void);
+
 #ifdef __cplusplus
 }
 #endif
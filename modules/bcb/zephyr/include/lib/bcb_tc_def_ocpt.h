@@ -0,0 +1,89 @@
+#ifndef _BCB_TC_DEF_OCPT_H_
+#define _BCB_TC_DEF_OCPT_H_
+
+#include <lib/bcb_sw.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A structure representing the result of an OCP self-test.
+ */
+typedef struct bcb_tc_def_ocpt_result {
+	uint16_t seq; /**< Sequence number of the self-test. */
+	bcb_ocp_direction_t direction; /**< Direction of the test current. */
+	bool passed; /**< Set to true if the switch opened within the time limit. */
+	uint32_t duration; /**< Time from the trigger to opening in nanoseconds.
+				UINT32_MAX if the switch did not open. */
+} bcb_tc_def_ocpt_result_t;
+
+/**
+ * A structure representing the trend of the recorded OCP self-tests in one direction.
+ * Durations are calculated only from passed tests.
+ */
+typedef struct bcb_tc_def_ocpt_trend {
+	uint8_t count; /**< Number of recorded tests. */
+	uint8_t failures; /**< Number of failed tests. */
+	uint32_t min; /**< Minimum duration in nanoseconds. */
+	uint32_t max; /**< Maximum duration in nanoseconds. */
+	uint32_t mean; /**< Mean duration in nanoseconds. */
+	int32_t drift; /**< Mean duration of the newer half minus the older half. */
+} bcb_tc_def_ocpt_trend_t;
+
+/**
+ * Initialises the OCP self-test scheduler.
+ */
+int bcb_tc_def_ocpt_init(void);
+
+/**
+ * Stops the OCP self-test scheduler, aborting a self-test in progress.
+ * Must be called before bcb_tc_def_ocpt_init() is called again.
+ */
+int bcb_tc_def_ocpt_shutdown(void);
+
+/**
+ * Check if a scheduled self-test has opened (or is about to open) the switch.
+ * The main state machine re-closes the switch instead of reporting a trip in that case.
+ */
+bool bcb_tc_def_ocpt_is_running(void);
+
+/**
+ * Start a self-test at the next low-load instant regardless of the interval.
+ * @return 0 on success, -EBUSY if a self-test is already in progress.
+ */
+int bcb_tc_def_ocpt_run(void);
+
+/**
+ * Set the self-test interval.
+ * @param[in] interval Interval in hours. 0 disables scheduled self-tests.
+ */
+int bcb_tc_def_ocpt_set_interval(uint16_t interval);
+
+/**
+ * Get the self-test interval in hours.
+ */
+uint16_t bcb_tc_def_ocpt_get_interval(void);
+
+/**
+ * Get a recorded self-test result.
+ * @param[in] index Index of the result, 0 being the latest.
+ * @param[out] result A pointer to the result structure.
+ * @return 0 on success, -ENOENT if there is no such result.
+ */
+int bcb_tc_def_ocpt_get_result(uint8_t index, bcb_tc_def_ocpt_result_t *result);
+
+/**
+ * Get the trend of the recorded self-tests.
+ * @param[in] direction Direction of the test current.
+ * @param[out] trend A pointer to the trend structure.
+ */
+int bcb_tc_def_ocpt_get_trend(bcb_ocp_direction_t direction, bcb_tc_def_ocpt_trend_t *trend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_TC_DEF_OCPT_H_ */
@@ -0,0 +1,70 @@
+#ifndef _BCB_TC_DEF_REC_H_
+#define _BCB_TC_DEF_REC_H_
+
+#include <lib/bcb_tc_def_msm.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A structure representing a recovery attempt.
+ */
+typedef struct bcb_tc_def_rec_attempt {
+	uint32_t timestamp; /**< Uptime in milliseconds when the attempt was scheduled. */
+	uint32_t delay; /**< Delay before closing in microseconds. */
+	uint32_t trip_duration; /**< Time from closing to the trip in nanoseconds.
+				     UINT32_MAX if the attempt did not trip. */
+	uint32_t inrush_peak; /**< Peak current after closing in milliamperes. */
+	uint32_t inrush_tail; /**< Peak current in the second half of the inrush capture window
+				   in milliamperes. Shows how far the inrush has decayed. */
+} bcb_tc_def_rec_attempt_t;
+
+/**
+ * Initialises the recovery policy.
+ */
+int bcb_tc_def_rec_init(void);
+
+/**
+ * Reset the recovery policy after the load has been stable (or on a user close).
+ * The attempt budget is not reset.
+ */
+void bcb_tc_def_rec_reset(void);
+
+/**
+ * Start capturing the inrush current after the switch has been closed.
+ */
+void bcb_tc_def_rec_on_close(void);
+
+/**
+ * Record the fault signature of an over current trip.
+ * @param[in] trip_duration Time from closing the switch to the trip in nanoseconds.
+ */
+void bcb_tc_def_rec_on_trip(uint32_t trip_duration);
+
+/**
+ * Decide on the next recovery attempt.
+ * @param[in] config Configuration of the main state machine.
+ * @param[in] attempt Index of the attempt starting from 0.
+ * @param[out] delay Delay before closing the switch in microseconds.
+ * @return 0 if the attempt is allowed,
+ *         -ECANCELED if a hard short has been detected,
+ *         -EDQUOT if the attempt budget has been exhausted.
+ */
+int bcb_tc_def_rec_next(const bcb_tc_def_msm_config_t *config, uint16_t attempt,
+			uint32_t *delay);
+
+/**
+ * Get a recorded recovery attempt.
+ * @param[in] index Index of the attempt, 0 being the latest.
+ * @param[out] attempt A pointer to the attempt structure.
+ * @return 0 on success, -ENOENT if there is no such attempt.
+ */
+int bcb_tc_def_rec_get_attempt(uint8_t index, bcb_tc_def_rec_attempt_t *attempt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_TC_DEF_REC_H_ */
@@ -0,0 +1,79 @@
+#ifndef _BCB_TIMER_H_
+#define _BCB_TIMER_H_
+
+#include <kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct bcb_timer;
+
+/**
+ * @brief Timer expiry handler.
+ *
+ * @param timer A pointer to the expired timer.
+ */
+typedef void (*bcb_timer_handler_t)(struct bcb_timer *timer);
+
+/**
+ * One-shot timer multiplexed over a single PIT channel. Expiry times are in elapsed time
+ * ticks, hence the resolution is not limited by the kernel tick.
+ * Fields are private; use the functions below.
+ */
+struct bcb_timer {
+	sys_snode_t node;
+	uint64_t expiry;
+	bcb_timer_handler_t handler;
+	struct k_work work;
+	bool is_work;
+	volatile bool is_active;
+	volatile bool is_pending;
+};
+
+/**
+ * Initialises the timer service.
+ */
+int bcb_timer_init(void);
+
+/**
+ * Set up a timer before its first use.
+ *
+ * @param timer A pointer to the timer.
+ * @param handler Called on expiry.
+ * @param is_work If true the handler is called in the system workqueue, otherwise it is called in
+ *		  the timer interrupt. A stopped timer never calls its handler in either case.
+ */
+void bcb_timer_setup(struct bcb_timer *timer, bcb_timer_handler_t handler, bool is_work);
+
+/**
+ * Start a timer to expire at the given elapsed time. A running timer is restarted.
+ *
+ * @return 0 on success, -ETIME if the time has already passed.
+ */
+int bcb_timer_start_at(struct bcb_timer *timer, uint64_t etime);
+
+/**
+ * Start a timer to expire after the given delay. A running timer is restarted.
+ *
+ * @param delay Delay in micro seconds.
+ */
+int bcb_timer_start(struct bcb_timer *timer, uint64_t delay);
+
+/**
+ * Stop a timer. Does nothing if the timer is not running.
+ */
+void bcb_timer_stop(struct bcb_timer *timer);
+
+/**
+ * Check if a timer is running.
+ */
+bool bcb_timer_is_active(struct bcb_timer *timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BCB_TIMER_H_ */
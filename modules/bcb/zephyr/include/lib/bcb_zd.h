@@ -2,6 +2,7 @@
 #define _BCB_ZD_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <sys/slist.h>
 
 #ifdef __cplusplus
@@ -19,6 +20,57 @@ struct bcb_zd_callback {
 
 int bcb_zd_init(void);
 uint32_t bcb_zd_get_frequency(void);
+/**
+ * @brief Get the filtered mains half-period of the PLL.
+ *
+ * @return uint32_t Half-period in elapsed time ticks, 0 if the PLL is not locked.
+ */
+uint32_t bcb_zd_get_half_period(void);
+/**
+ * @brief Get the filtered mains period of the PLL.
+ *
+ * @return uint32_t Period in elapsed time ticks, 0 if the PLL is not locked.
+ */
+uint32_t bcb_zd_get_period(void);
+/**
+ * @brief Check if the mains PLL is locked to the voltage zero-crossings.
+ */
+bool bcb_zd_is_locked(void);
+/**
+ * @brief Get the mains phase angle at the given time.
+ *
+ * The phase is 0 at the rising edge of the zero-crossing detector output and 32768 (180
+ * degrees) at the falling edge.
+ *
+ * @param etime		Elapsed time ticks
+ * @param phase		Phase angle, 65536 being a full mains cycle
+ * @retval 0		On success.
+ * @retval -EAGAIN	If the PLL is not locked.
+ */
+int bcb_zd_get_phase(uint64_t etime, uint16_t *phase);
+/**
+ * @brief Predict the elapsed time of the next zero-crossing.
+ *
+ * Voltage zero-crossings are predicted by the mains PLL. The error of a voltage prediction
+ * is measured against the edge that is captured next. Current zero-crossings are predicted
+ * only while their detection is enabled.
+ *
+ * @param type		Voltage or current
+ * @param etime		Predicted elapsed time ticks
+ * @retval 0		On success.
+ * @retval -EAGAIN	If the mains is not being tracked (yet).
+ */
+int bcb_zd_get_next_crossing(bcb_zd_type_t type, uint64_t *etime);
+/**
+ * @brief Get the error of the last zero-crossing prediction.
+ *
+ * @return int32_t Captured edge time minus the predicted time in nano seconds.
+ */
+int32_t bcb_zd_get_prediction_error(void);
+/**
+ * @brief Get the number of voltage zero-crossing edges rejected as glitches.
+ */
+uint32_t bcb_zd_get_glitch_count(void);
 int bcb_zd_voltage_add_callback(struct bcb_zd_callback *callback);
 int bcb_zd_add_callback(bcb_zd_type_t type, struct bcb_zd_callback *callback);
 void bcb_zd_remove_callback(bcb_zd_type_t type, struct bcb_zd_callback *callback);
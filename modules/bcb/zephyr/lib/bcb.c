@@ -1,10 +1,13 @@
 #include <lib/bcb.h>
+#include <lib/bcb_boot.h>
 #include <lib/bcb_config.h>
 #include <lib/bcb_msmnt.h>
 #include <lib/bcb_tc.h>
 #include <errno.h>
 #include <kernel.h>
 
+#define BCB_STATE_VERSION 1
+
 #define LOG_LEVEL CONFIG_BCB_LOG_LEVEL
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bcb);
@@ -14,6 +17,8 @@ typedef struct __attribute__((packed)) bcb_state {
 	bcb_ini_state_t ini_state;
 } bcb_state_t;
 
+BCB_CONFIG_LOG_ASSERT_SIZE(BCB, sizeof(bcb_state_t));
+
 struct bcb_data {
 	const struct bcb_tc *trip_curve;
 	sys_slist_t callback_list;
@@ -87,8 +92,8 @@ static void bcb_work(struct k_work *work)
 		}
 	}
 
-	r = bcb_config_store(CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_BCB,
-			     (uint8_t *)&bcb_data.state, sizeof(bcb_data.state));
+	r = bcb_config_log_store(BCB_CONFIG_LOG_ID_BCB, BCB_STATE_VERSION,
+				 (uint8_t *)&bcb_data.state, sizeof(bcb_data.state));
 
 	if (r) {
 		LOG_WRN("cannot save configuration: %d", r);
@@ -97,17 +102,13 @@ static void bcb_work(struct k_work *work)
 
 int bcb_init()
 {
-	int r;
-
 	memset(&bcb_data, 0, sizeof(bcb_data));
 	sys_slist_init(&bcb_data.callback_list);
 	k_work_init(&bcb_data.bcb_work, bcb_work);
 
-	r = bcb_config_load(CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_BCB,
-			    (uint8_t *)&bcb_data.state, sizeof(bcb_data.state));
-	if (r) {
-		load_default_state();
-	}
+	load_default_state();
+	bcb_config_log_load(BCB_CONFIG_LOG_ID_BCB, BCB_STATE_VERSION, (uint8_t *)&bcb_data.state,
+			    sizeof(bcb_data.state), NULL);
 
 	return 0;
 }
@@ -218,6 +219,11 @@ int bcb_set_tc(const bcb_tc_t *curve)
 		return -EINVAL;
 	}
 
+	if (bcb_data.trip_curve == curve) {
+		/* Already set during the system initialisation. */
+		return 0;
+	}
+
 	if (bcb_data.trip_curve) {
 		if ((r = bcb_data.trip_curve->shutdown())) {
 			LOG_WRN("trip curve shutdown failed: %d", r);
@@ -231,6 +237,7 @@ int bcb_set_tc(const bcb_tc_t *curve)
 	}
 
 	bcb_data.trip_curve->set_callback(trip_curve_callback);
+	bcb_boot_mark(BCB_BOOT_STAGE_TC);
 
 	switch (bcb_data.state.ini_state) {
 	case BCB_INI_STATE_OPENED:
@@ -0,0 +1,92 @@
+#include <lib/bcb_boot.h>
+#include <lib/bcb_etime.h>
+#include <kernel.h>
+#include <errno.h>
+
+#define LOG_LEVEL CONFIG_BCB_LIB_BOOT_LOG_LEVEL
+#include <logging/log.h>
+LOG_MODULE_REGISTER(bcb_boot);
+
+struct bcb_boot_data {
+	uint64_t etime_start; /* Kernel uptime when the elapsed time timer started (us) */
+	uint64_t stamps[BCB_BOOT_STAGE_END]; /* Elapsed time ticks */
+	uint32_t marked; /* One bit per stage */
+};
+
+static struct bcb_boot_data boot_data;
+
+static const char *const stage_names[BCB_BOOT_STAGE_END] = {
+	[BCB_BOOT_STAGE_ETIME] = "etime",
+	[BCB_BOOT_STAGE_TIMER] = "timer",
+	[BCB_BOOT_STAGE_CONFIG] = "config",
+	[BCB_BOOT_STAGE_ZD] = "zd",
+	[BCB_BOOT_STAGE_MSMNT] = "msmnt",
+	[BCB_BOOT_STAGE_SW] = "sw",
+	[BCB_BOOT_STAGE_BCB] = "bcb",
+	[BCB_BOOT_STAGE_COAP] = "coap",
+	[BCB_BOOT_STAGE_SHELL] = "shell",
+	[BCB_BOOT_STAGE_TC] = "tc",
+	[BCB_BOOT_STAGE_CLOSED] = "closed",
+};
+
+BUILD_ASSERT(BCB_BOOT_STAGE_END <= 32, "Stage mask is too small");
+
+int bcb_boot_init(void)
+{
+	uint64_t now = bcb_etime_get_now();
+
+	/* Stamps are taken with the elapsed time timer, which starts later than the kernel. */
+	boot_data.etime_start = k_cyc_to_us_floor64(k_cycle_get_32()) - bcb_etime_to_ns(now) / 1000;
+	boot_data.marked = 0;
+	bcb_boot_mark(BCB_BOOT_STAGE_ETIME);
+
+	return 0;
+}
+
+void bcb_boot_mark(bcb_boot_stage_t stage)
+{
+	uint64_t now = bcb_etime_get_now();
+	unsigned int key;
+	bool is_first;
+
+	if (stage >= BCB_BOOT_STAGE_END) {
+		return;
+	}
+
+	key = irq_lock();
+	is_first = !(boot_data.marked & BIT(stage));
+	if (is_first) {
+		boot_data.stamps[stage] = now;
+		boot_data.marked |= BIT(stage);
+	}
+	irq_unlock(key);
+
+	if (is_first && stage == BCB_BOOT_STAGE_CLOSED) {
+		LOG_INF("closed %" PRIu64 " us after boot",
+			boot_data.etime_start + bcb_etime_to_ns(now) / 1000);
+	}
+}
+
+int bcb_boot_get_time(bcb_boot_stage_t stage, uint64_t *time)
+{
+	if (stage >= BCB_BOOT_STAGE_END) {
+		return -EINVAL;
+	}
+
+	if (!(boot_data.marked & BIT(stage))) {
+		return -ENOENT;
+	}
+
+	*time = boot_data.etime_start + bcb_etime_to_ns(boot_data.stamps[stage]) / 1000;
+
+	return 0;
+}
+
+const char *bcb_boot_get_stage_name(bcb_boot_stage_t stage)
+{
+	if (stage >= BCB_BOOT_STAGE_END) {
+		return "unknown";
+	}
+
+	return stage_names[stage];
+}
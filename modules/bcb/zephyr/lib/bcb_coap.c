@@ -18,22 +18,53 @@
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bcb_coap);
 
+/* Number of hash buckets of the notifiers and the pending messages. */
+#define HASH_BUCKETS 16
+
+/* Pending requests hold their buffers, so some must be left for responses and notifications. */
+BUILD_ASSERT(CONFIG_BCB_COAP_MAX_BUF_COUNT > CONFIG_BCB_COAP_MAX_PENDING,
+	     "CONFIG_BCB_COAP_MAX_BUF_COUNT must be larger than CONFIG_BCB_COAP_MAX_PENDING");
+
 struct async_notify_item {
 	struct coap_resource *resource;
 };
 
+/* Min-heap of timers, the earliest expiry first. */
+struct timer_heap {
+	struct bcb_coap_timer **items;
+	uint16_t count;
+};
+
+struct pending_entry {
+	struct coap_pending pending;
+	sys_snode_t id_node; /* Message ID bucket */
+	sys_snode_t addr_node; /* Address bucket or free list */
+	struct bcb_coap_timer timer; /* Next retransmission */
+};
+
 struct bcb_coap_data {
 	int socket;
 	uint8_t req_buf[CONFIG_BCB_COAP_MAX_MSG_LEN];
 	uint8_t res_buf[CONFIG_BCB_COAP_MAX_MSG_LEN];
-	struct coap_pending pendings[CONFIG_BCB_COAP_MAX_PENDING];
+	struct pending_entry pendings[CONFIG_BCB_COAP_MAX_PENDING];
+	struct bcb_coap_timer *pending_timers[CONFIG_BCB_COAP_MAX_PENDING];
+	struct timer_heap pending_heap;
+	sys_slist_t pending_free;
+	sys_slist_t pending_by_id[HASH_BUCKETS];
+	sys_slist_t pending_by_addr[HASH_BUCKETS];
+	/* Notifier i uses observer i. */
 	struct coap_observer observers[CONFIG_BCB_COAP_MAX_OBSERVERS];
 	struct bcb_coap_notifier notifiers[CONFIG_BCB_COAP_MAX_OBSERVERS];
+	struct bcb_coap_timer *notifier_timers[CONFIG_BCB_COAP_MAX_OBSERVERS];
+	struct timer_heap notifier_heap;
+	sys_slist_t notifier_free;
+	sys_slist_t notifier_by_addr[HASH_BUCKETS];
 	struct k_delayed_work retransmit_work;
 	struct k_delayed_work observer_work;
 	struct k_work async_notify_work;
 	struct k_work receive_work;
 	struct k_fifo fifo;
+	uint32_t notify_round;
 	struct k_thread thread;
 	K_THREAD_STACK_MEMBER(stack, CONFIG_BCB_COAP_THREAD_STACK_SIZE);
 	struct coap_resource resources[];
@@ -72,6 +103,20 @@ static struct bcb_coap_data bcb_coap_data = {
                         }),
             .path = BCB_COAP_RESOURCE_DEVICE_PATH,
         },
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+        {   .post = bcb_coap_handlers_stats_post,
+            .user_data = &((struct coap_core_metadata){
+                            .attributes = BCB_COAP_RESOURCE_STATS_ATTRIBUTES,
+                        }),
+            .path = BCB_COAP_RESOURCE_STATS_PATH,
+        },
+        {   .post = bcb_coap_handlers_journal_post,
+            .user_data = &((struct coap_core_metadata){
+                            .attributes = BCB_COAP_RESOURCE_JOURNAL_ATTRIBUTES,
+                        }),
+            .path = BCB_COAP_RESOURCE_JOURNAL_PATH,
+        },
+#endif
 #if 0
         {   .get = bcb_coap_handlers_switch_get,
             .post = bcb_coap_handlers_switch_post,
@@ -127,50 +172,199 @@ static bool is_sockaddr_equal(const struct sockaddr *a, const struct sockaddr *b
 	return false;
 }
 
-static void notifier_remove_by_addr(const struct sockaddr *addr)
+static uint8_t addr_hash(const struct sockaddr *addr)
 {
-	int i;
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-		struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-		if (!notifier->is_used) {
-			continue;
+	const uint8_t *bytes;
+	uint32_t hash;
+	size_t len;
+	size_t i;
+
+	if (addr->sa_family == AF_INET) {
+		bytes = (const uint8_t *)&net_sin(addr)->sin_addr;
+		len = sizeof(struct in_addr);
+		hash = net_sin(addr)->sin_port;
+	} else if (addr->sa_family == AF_INET6) {
+		bytes = (const uint8_t *)&net_sin6(addr)->sin6_addr;
+		len = sizeof(struct in6_addr);
+		hash = net_sin6(addr)->sin6_port;
+	} else {
+		return 0;
+	}
+
+	for (i = 0; i < len; i++) {
+		hash = hash * 31 + bytes[i];
+	}
+
+	return hash % HASH_BUCKETS;
+}
+
+static inline uint8_t id_hash(uint16_t id)
+{
+	/* Message IDs are sequential, so they spread evenly. */
+	return id % HASH_BUCKETS;
+}
+
+static inline bool timer_is_before(const struct bcb_coap_timer *a, const struct bcb_coap_timer *b)
+{
+	/* Uptime wraps around, hence the signed difference. */
+	return (int32_t)(a->expiry - b->expiry) < 0;
+}
+
+static void heap_swap(struct timer_heap *heap, uint16_t i, uint16_t j)
+{
+	struct bcb_coap_timer *timer = heap->items[i];
+
+	heap->items[i] = heap->items[j];
+	heap->items[j] = timer;
+	heap->items[i]->index = i;
+	heap->items[j]->index = j;
+}
+
+static void heap_sift_up(struct timer_heap *heap, uint16_t i)
+{
+	while (i > 0 && timer_is_before(heap->items[i], heap->items[(i - 1) / 2])) {
+		heap_swap(heap, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+static void heap_sift_down(struct timer_heap *heap, uint16_t i)
+{
+	uint16_t child;
+
+	while (true) {
+		child = 2 * i + 1;
+		if (child >= heap->count) {
+			break;
 		}
 
-		if (is_sockaddr_equal(addr, &notifier->observer->addr)) {
-			coap_remove_observer(notifier->resource, notifier->observer);
-			memset(notifier->observer, 0, sizeof(struct coap_observer));
-			notifier->is_used = false;
+		if (child + 1 < heap->count &&
+		    timer_is_before(heap->items[child + 1], heap->items[child])) {
+			child++;
+		}
+
+		if (!timer_is_before(heap->items[child], heap->items[i])) {
+			break;
 		}
+
+		heap_swap(heap, i, child);
+		i = child;
 	}
 }
 
-int bcb_coap_notifier_remove(const struct sockaddr *addr, const uint8_t *token, uint8_t tkl)
+/* The heap has room for every entry of its pool, and an entry is pushed at most once. */
+static void heap_push(struct timer_heap *heap, struct bcb_coap_timer *timer, uint32_t expiry)
 {
-	int i;
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-		struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-		if (!notifier->is_used) {
-			continue;
-		}
+	timer->expiry = expiry;
+	timer->index = heap->count;
+	heap->items[heap->count++] = timer;
+	heap_sift_up(heap, timer->index);
+}
+
+static void heap_update(struct timer_heap *heap, struct bcb_coap_timer *timer, uint32_t expiry)
+{
+	timer->expiry = expiry;
+	heap_sift_up(heap, timer->index);
+	heap_sift_down(heap, timer->index);
+}
+
+static void heap_remove(struct timer_heap *heap, struct bcb_coap_timer *timer)
+{
+	uint16_t i = timer->index;
+
+	heap->count--;
+	if (i == heap->count) {
+		return;
+	}
+
+	/* The last timer takes the place of the removed one. */
+	heap_swap(heap, i, heap->count);
+	heap_sift_up(heap, i);
+	heap_sift_down(heap, i);
+}
+
+static inline struct bcb_coap_timer *heap_peek(struct timer_heap *heap)
+{
+	return heap->count ? heap->items[0] : NULL;
+}
+
+/* Delay until a timer expires, 0 if it has already expired. */
+static inline uint32_t timer_remaining(struct bcb_coap_timer *timer, uint32_t t_now)
+{
+	return (int32_t)(timer->expiry - t_now) > 0 ? timer->expiry - t_now : 0;
+}
+
+static inline struct bcb_coap_notifier *notifier_of(struct coap_observer *observer)
+{
+	return &bcb_coap_data.notifiers[observer - bcb_coap_data.observers];
+}
+
+static void notifier_remove(struct bcb_coap_notifier *notifier)
+{
+	sys_slist_find_and_remove(&bcb_coap_data.notifier_by_addr[addr_hash(
+					  &notifier->observer->addr)],
+				  &notifier->node);
+	if (notifier->period) {
+		heap_remove(&bcb_coap_data.notifier_heap, &notifier->timer);
+	}
 
+	coap_remove_observer(notifier->resource, notifier->observer);
+	memset(notifier->observer, 0, sizeof(struct coap_observer));
+	notifier->is_used = false;
+	sys_slist_prepend(&bcb_coap_data.notifier_free, &notifier->node);
+}
+
+static struct bcb_coap_notifier *notifier_find(const struct sockaddr *addr, const uint8_t *token,
+					       uint8_t tkl)
+{
+	struct bcb_coap_notifier *notifier;
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&bcb_coap_data.notifier_by_addr[addr_hash(addr)], notifier,
+				      node) {
 		if (is_sockaddr_equal(addr, &notifier->observer->addr) &&
+		    notifier->observer->tkl == tkl &&
 		    memcmp(token, notifier->observer->token, tkl) == 0) {
-			coap_remove_observer(notifier->resource, notifier->observer);
-			memset(notifier->observer, 0, sizeof(struct coap_observer));
-			notifier->is_used = false;
-			return 0;
+			return notifier;
+		}
+	}
+
+	return NULL;
+}
+
+static void notifier_remove_by_addr(const struct sockaddr *addr)
+{
+	struct bcb_coap_notifier *notifier;
+	struct bcb_coap_notifier *next;
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE (&bcb_coap_data.notifier_by_addr[addr_hash(addr)],
+					   notifier, next, node) {
+		if (is_sockaddr_equal(addr, &notifier->observer->addr)) {
+			notifier_remove(notifier);
 		}
 	}
+}
+
+int bcb_coap_notifier_remove(const struct sockaddr *addr, const uint8_t *token, uint8_t tkl)
+{
+	struct bcb_coap_notifier *notifier;
+
+	notifier = notifier_find(addr, token, tkl);
+	if (!notifier) {
+		return -ENOENT;
+	}
 
-	return -ENOENT;
+	notifier_remove(notifier);
+
+	return 0;
 }
 
 bool bcb_coap_has_pending(const struct sockaddr *addr)
 {
-	int i;
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_PENDING; i++) {
-		if (bcb_coap_data.pendings[i].timeout != 0 &&
-		    is_sockaddr_equal(addr, &bcb_coap_data.pendings[i].addr)) {
+	struct pending_entry *entry;
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&bcb_coap_data.pending_by_addr[addr_hash(addr)], entry,
+				      addr_node) {
+		if (is_sockaddr_equal(addr, &entry->pending.addr)) {
 			return true;
 		}
 	}
@@ -178,108 +372,125 @@ bool bcb_coap_has_pending(const struct sockaddr *addr)
 	return false;
 }
 
-void pending_remove(struct coap_pending *pending)
+static struct pending_entry *pending_find(uint16_t id, const struct sockaddr *addr)
+{
+	struct pending_entry *entry;
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&bcb_coap_data.pending_by_id[id_hash(id)], entry, id_node) {
+		if (entry->pending.id == id && is_sockaddr_equal(addr, &entry->pending.addr)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static void pending_remove(struct pending_entry *entry)
 {
 	/* pending->data has been replaced with the pointer to net_buf  */
-	struct net_buf *buf = (struct net_buf *)pending->data;
+	struct net_buf *buf = (struct net_buf *)entry->pending.data;
 	bcb_coap_buf_free(buf);
-	//coap_pending_clear(pending); /* Next step will do the same */
-	memset(pending, 0, sizeof(struct coap_pending));
+
+	sys_slist_find_and_remove(&bcb_coap_data.pending_by_id[id_hash(entry->pending.id)],
+				  &entry->id_node);
+	sys_slist_find_and_remove(&bcb_coap_data.pending_by_addr[addr_hash(&entry->pending.addr)],
+				  &entry->addr_node);
+	heap_remove(&bcb_coap_data.pending_heap, &entry->timer);
+
+	memset(&entry->pending, 0, sizeof(struct coap_pending));
+	sys_slist_prepend(&bcb_coap_data.pending_free, &entry->addr_node);
 }
 
-void pending_remove_by_addr(const struct sockaddr *addr)
+static void pending_remove_by_addr(const struct sockaddr *addr)
 {
-	int i;
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_PENDING; i++) {
-		if (bcb_coap_data.pendings[i].timeout != 0 &&
-		    is_sockaddr_equal(addr, &bcb_coap_data.pendings[i].addr)) {
-			pending_remove(&bcb_coap_data.pendings[i]);
+	struct pending_entry *entry;
+	struct pending_entry *next;
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE (&bcb_coap_data.pending_by_addr[addr_hash(addr)], entry,
+					   next, addr_node) {
+		if (is_sockaddr_equal(addr, &entry->pending.addr)) {
+			pending_remove(entry);
 		}
 	}
 }
 
-static void retransmit_work(struct k_work *work)
+static void pending_schedule(void)
 {
-	struct coap_pending *pending;
-	struct net_buf *buf;
-	int r;
+	struct bcb_coap_timer *timer = heap_peek(&bcb_coap_data.pending_heap);
 
-	pending = coap_pending_next_to_expire(bcb_coap_data.pendings, CONFIG_BCB_COAP_MAX_PENDING);
-	if (!pending) {
+	if (!timer) {
 		return;
 	}
 
-	buf = (struct net_buf *)pending->data;
-	r = sendto(bcb_coap_data.socket, buf->data, buf->len, 0, &pending->addr,
-		   sizeof(struct sockaddr));
-	if (r < 0) {
-		LOG_ERR("failed to send %d", errno);
-	}
-
-	if (!coap_pending_cycle(pending)) {
-		/* This is the last retransmission */
-		notifier_remove_by_addr(&pending->addr);
-		pending_remove(pending);
-		LOG_INF("removed stale observer");
-	}
-
-	pending = coap_pending_next_to_expire(bcb_coap_data.pendings, CONFIG_BCB_COAP_MAX_PENDING);
-	if (pending) {
-		k_delayed_work_submit(&bcb_coap_data.retransmit_work, K_MSEC(pending->timeout));
-	}
+	k_delayed_work_submit(&bcb_coap_data.retransmit_work,
+			      K_MSEC(timer_remaining(timer, k_uptime_get_32())));
 }
 
-static void periodic_notifier_schedule()
+static void retransmit_work(struct k_work *work)
 {
-	int i;
+	struct bcb_coap_timer *timer;
+	struct pending_entry *entry;
+	struct net_buf *buf;
 	uint32_t t_now;
-	uint32_t t_d = UINT32_MAX;
+	int r;
 
 	t_now = k_uptime_get_32();
 
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-		struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-		if (!notifier->is_used) {
-			continue;
+	while ((timer = heap_peek(&bcb_coap_data.pending_heap)) &&
+	       !timer_remaining(timer, t_now)) {
+		entry = CONTAINER_OF(timer, struct pending_entry, timer);
+
+		buf = (struct net_buf *)entry->pending.data;
+		r = sendto(bcb_coap_data.socket, buf->data, buf->len, 0, &entry->pending.addr,
+			   sizeof(struct sockaddr));
+		if (r < 0) {
+			LOG_ERR("failed to send %d", errno);
 		}
 
-		if (!notifier->period) {
+		if (!coap_pending_cycle(&entry->pending)) {
+			/* This is the last retransmission */
+			notifier_remove_by_addr(&entry->pending.addr);
+			pending_remove(entry);
+			LOG_INF("removed stale observer");
 			continue;
 		}
 
-		if (notifier->start + notifier->period - t_now < t_d) {
-			t_d = notifier->start + notifier->period - t_now;
-		}
+		heap_update(&bcb_coap_data.pending_heap, timer, t_now + entry->pending.timeout);
 	}
 
-	if (t_d == UINT32_MAX) {
+	pending_schedule();
+}
+
+static void periodic_notifier_schedule()
+{
+	struct bcb_coap_timer *timer = heap_peek(&bcb_coap_data.notifier_heap);
+
+	if (!timer) {
 		return;
 	}
 
-	k_delayed_work_submit(&bcb_coap_data.observer_work, K_MSEC(t_d));
+	k_delayed_work_submit(&bcb_coap_data.observer_work,
+			      K_MSEC(timer_remaining(timer, k_uptime_get_32())));
 }
 
 static void observer_notify_work(struct k_work *work)
 {
-	int i;
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-		struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-		uint32_t t_now;
-
-		if (!notifier->is_used) {
-			continue;
-		}
+	struct bcb_coap_timer *timer;
+	uint32_t t_now;
 
-		if (!notifier->period) {
-			continue;
-		}
+	/* Observers due at the same time get the same notification. The same time is used for all
+	 * of them so that observers with the same period stay together.
+	 */
+	bcb_coap_data.notify_round++;
+	t_now = k_uptime_get_32();
 
-		t_now = k_uptime_get_32();
-		if (t_now - notifier->start < notifier->period) {
-			continue;
-		}
+	while ((timer = heap_peek(&bcb_coap_data.notifier_heap)) &&
+	       !timer_remaining(timer, t_now)) {
+		struct bcb_coap_notifier *notifier =
+			CONTAINER_OF(timer, struct bcb_coap_notifier, timer);
 
 		notifier->start = t_now;
+		heap_update(&bcb_coap_data.notifier_heap, timer, t_now + notifier->period);
 
 		if (!notifier->resource->notify) {
 			continue;
@@ -296,20 +507,19 @@ static void async_notify_work(struct k_work *work)
 	struct async_notify_item item;
 
 	while (!k_msgq_get(&async_notify_msgq, &item, K_NO_WAIT)) {
-		int i;
-		for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-			struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-			if (!notifier->is_used) {
-				continue;
-			}
+		struct coap_observer *observer;
+		struct coap_observer *next;
 
-			if (notifier->resource != item.resource) {
-				continue;
-			}
+		bcb_coap_data.notify_round++;
 
-			if (!notifier->resource->notify) {
-				continue;
-			}
+		if (!item.resource->notify) {
+			continue;
+		}
+
+		/* A notification may remove the observer. */
+		SYS_SLIST_FOR_EACH_CONTAINER_SAFE (&item.resource->observers, observer, next,
+						   list) {
+			struct bcb_coap_notifier *notifier = notifier_of(observer);
 
 			notifier->is_async = true;
 			notifier->resource->notify(notifier->resource, notifier->observer);
@@ -320,14 +530,18 @@ static void async_notify_work(struct k_work *work)
 
 static int create_pending_request(struct coap_packet *packet, const struct sockaddr *addr)
 {
+	struct pending_entry *entry;
 	struct coap_pending *pending;
 	struct net_buf *buf;
+	sys_snode_t *node;
 	int r;
 
-	pending = coap_pending_next_unused(bcb_coap_data.pendings, CONFIG_BCB_COAP_MAX_PENDING);
-	if (!pending) {
+	node = sys_slist_peek_head(&bcb_coap_data.pending_free);
+	if (!node) {
 		return -ENOMEM;
 	}
+	entry = CONTAINER_OF(node, struct pending_entry, addr_node);
+	pending = &entry->pending;
 
 	r = coap_pending_init(pending, packet, addr);
 	if (r < 0) {
@@ -344,17 +558,17 @@ static int create_pending_request(struct coap_packet *packet, const struct socka
 
 	coap_pending_cycle(pending);
 
-	pending = coap_pending_next_to_expire(bcb_coap_data.pendings, CONFIG_BCB_COAP_MAX_PENDING);
-	if (!pending) {
-		return -EINVAL;
-	}
+	sys_slist_get_not_empty(&bcb_coap_data.pending_free);
+	sys_slist_append(&bcb_coap_data.pending_by_id[id_hash(pending->id)], &entry->id_node);
+	sys_slist_append(&bcb_coap_data.pending_by_addr[addr_hash(addr)], &entry->addr_node);
+	heap_push(&bcb_coap_data.pending_heap, &entry->timer,
+		  k_uptime_get_32() + pending->timeout);
 
-	if (k_delayed_work_remaining_ticks(&bcb_coap_data.retransmit_work)) {
-		return 0;
+	if (heap_peek(&bcb_coap_data.pending_heap) == &entry->timer) {
+		/* The earliest retransmission has changed. */
+		pending_schedule();
 	}
 
-	k_delayed_work_submit(&bcb_coap_data.retransmit_work, K_MSEC(pending->timeout));
-
 	return 0;
 }
 
@@ -383,11 +597,33 @@ uint8_t *bcb_coap_response_buffer()
 	return bcb_coap_data.res_buf;
 }
 
+uint32_t bcb_coap_get_notify_round(void)
+{
+	return bcb_coap_data.notify_round;
+}
+
+/* Observers of a resource with the same period are notified together. */
+static uint32_t notifier_get_start(struct coap_resource *resource, uint32_t period)
+{
+	struct coap_observer *observer;
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&resource->observers, observer, list) {
+		struct bcb_coap_notifier *notifier = notifier_of(observer);
+		if (notifier->period == period) {
+			return notifier->start;
+		}
+	}
+
+	return k_uptime_get_32();
+}
+
 int bcb_coap_notifier_add(struct coap_resource *resource, struct coap_packet *request,
 			  struct sockaddr *addr, uint32_t period)
 {
-	int i;
-	struct coap_observer *observer;
+	struct bcb_coap_notifier *notifier;
+	uint8_t token[8];
+	sys_snode_t *node;
+	uint8_t tkl;
 
 	if (!resource->notify) {
 		LOG_WRN("notification not implemented");
@@ -398,33 +634,37 @@ int bcb_coap_notifier_add(struct coap_resource *resource, struct coap_packet *re
 		period = CONFIG_BCB_COAP_MIN_OBSERVE_PERIOD;
 	}
 
-	observer =
-		coap_observer_next_unused(bcb_coap_data.observers, CONFIG_BCB_COAP_MAX_OBSERVERS);
+	tkl = coap_header_get_token(request, token);
+	notifier = notifier_find(addr, token, tkl);
+	if (notifier) {
+		/* A re-registration replaces the previous one. */
+		notifier_remove(notifier);
+	}
 
-	if (!observer) {
+	node = sys_slist_get(&bcb_coap_data.notifier_free);
+	if (!node) {
 		LOG_WRN("cannot find unused observer");
 		return -ENOMEM;
 	}
+	notifier = CONTAINER_OF(node, struct bcb_coap_notifier, node);
 
-	coap_observer_init(observer, request, addr);
-	coap_register_observer(resource, observer);
+	notifier->start = notifier_get_start(resource, period);
+	notifier->resource = resource;
+	notifier->seq = 0;
+	notifier->period = period;
+	notifier->msgs_no_ack = CONFIG_BCB_COAP_MAX_MSGS_NO_ACK;
+	notifier->is_async = false;
+	notifier->is_used = true;
 
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-		struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-		if (!notifier->is_used) {
-			notifier = &bcb_coap_data.notifiers[i];
-			notifier->is_used = true;
-			notifier->resource = resource;
-			notifier->observer = observer;
-			notifier->seq = 0;
-			notifier->period = period;
-			notifier->msgs_no_ack = CONFIG_BCB_COAP_MAX_MSGS_NO_ACK;
-			notifier->start = k_uptime_get_32();
-			break;
-		}
-	}
+	coap_observer_init(notifier->observer, request, addr);
+	coap_register_observer(resource, notifier->observer);
+	sys_slist_append(&bcb_coap_data.notifier_by_addr[addr_hash(addr)], &notifier->node);
 
-	periodic_notifier_schedule();
+	if (period) {
+		heap_push(&bcb_coap_data.notifier_heap, &notifier->timer,
+			  notifier->start + period);
+		periodic_notifier_schedule();
+	}
 
 	return 0;
 }
@@ -432,16 +672,19 @@ int bcb_coap_notifier_add(struct coap_resource *resource, struct coap_packet *re
 struct bcb_coap_notifier *bcb_coap_get_notifier(struct coap_resource *resource,
 						struct coap_observer *observer)
 {
-	int i;
-	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
-		struct bcb_coap_notifier *notifier = &bcb_coap_data.notifiers[i];
-		if (notifier->is_used && notifier->resource == resource &&
-		    notifier->observer == observer) {
-			return notifier;
-		}
+	struct bcb_coap_notifier *notifier;
+
+	if (observer < bcb_coap_data.observers ||
+	    observer >= bcb_coap_data.observers + CONFIG_BCB_COAP_MAX_OBSERVERS) {
+		return NULL;
 	}
 
-	return NULL;
+	notifier = notifier_of(observer);
+	if (!notifier->is_used || notifier->resource != resource) {
+		return NULL;
+	}
+
+	return notifier;
 }
 
 static bool is_uri_path_equal(const char *const *path1, const char *const *path2)
@@ -515,14 +758,13 @@ static int process_coap_packet(uint8_t *data, uint8_t data_len, struct sockaddr
 	type = coap_header_get_type(&packet);
 
 	if (type == COAP_TYPE_ACK) {
-		struct coap_pending *pending;
-		pending = coap_pending_received(&packet, bcb_coap_data.pendings,
-						CONFIG_BCB_COAP_MAX_PENDING);
-		if (!pending) {
+		struct pending_entry *entry;
+		entry = pending_find(coap_header_get_id(&packet), client_addr);
+		if (!entry) {
 			LOG_WRN("recevied ACK, but no pending");
 			return -EINVAL;
 		}
-		pending_remove(pending);
+		pending_remove(entry);
 		return 0;
 
 	} else if (type == COAP_TYPE_RESET) {
@@ -620,7 +862,32 @@ int bcb_coap_start_server()
 
 int bcb_coap_init(void)
 {
+	int i;
+
 	memset(&bcb_coap_data.notifiers, 0, sizeof(bcb_coap_data.notifiers));
+	memset(&bcb_coap_data.pendings, 0, sizeof(bcb_coap_data.pendings));
+
+	for (i = 0; i < HASH_BUCKETS; i++) {
+		sys_slist_init(&bcb_coap_data.pending_by_id[i]);
+		sys_slist_init(&bcb_coap_data.pending_by_addr[i]);
+		sys_slist_init(&bcb_coap_data.notifier_by_addr[i]);
+	}
+
+	sys_slist_init(&bcb_coap_data.pending_free);
+	for (i = 0; i < CONFIG_BCB_COAP_MAX_PENDING; i++) {
+		sys_slist_append(&bcb_coap_data.pending_free, &bcb_coap_data.pendings[i].addr_node);
+	}
+	bcb_coap_data.pending_heap.items = bcb_coap_data.pending_timers;
+	bcb_coap_data.pending_heap.count = 0;
+
+	sys_slist_init(&bcb_coap_data.notifier_free);
+	for (i = 0; i < CONFIG_BCB_COAP_MAX_OBSERVERS; i++) {
+		bcb_coap_data.notifiers[i].observer = &bcb_coap_data.observers[i];
+		sys_slist_append(&bcb_coap_data.notifier_free, &bcb_coap_data.notifiers[i].node);
+	}
+	bcb_coap_data.notifier_heap.items = bcb_coap_data.notifier_timers;
+	bcb_coap_data.notifier_heap.count = 0;
+
 	k_delayed_work_init(&bcb_coap_data.retransmit_work, retransmit_work);
 	k_delayed_work_init(&bcb_coap_data.observer_work, observer_notify_work);
 	k_work_init(&bcb_coap_data.async_notify_work, async_notify_work);
@@ -5,10 +5,13 @@
 #include <lib/bcb_coap_buffer.h>
 #include <lib/bcb_msmnt.h>
 #include <lib/bcb_sw.h>
+#include <lib/bcb_sw_stats.h>
+#include <lib/bcb_journal.h>
 #include <lib/bcb.h>
 #include <lib/bcb_tc_def.h>
 #include <lib/bcb_tc_def_msm.h>
 #include <lib/bcb_tc_def_csom_mod.h>
+#include <lib/bcb_tc_def_csom_sd.h>
 #include <stdbool.h>
 #include <zc_messages.pb.h>
 #include <pb.h>
@@ -27,11 +30,21 @@
 
 #define COAP_CONTENT_FORMAT_NANOPB 30001
 #define MAX_CURVE_POINTS CONFIG_BCB_TRIP_CURVE_DEFAULT_MAX_POINTS
+/* Space left in a response for the header, token and options of a block. */
+#define BLOCK_OVERHEAD 48
 
 #define LOG_LEVEL CONFIG_BCB_COAP_LOG_LEVEL
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bcb_coap_handlers);
 
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+/* The generated messages must match docs/proto_files/zc_messages.proto. */
+#if !defined(ZC_CSOM_CONFIG_SD_TAG) || !defined(ZC_OCP_HW_CONFIG_REC_POLICY_TAG) ||                \
+    !defined(ZC_REQUEST_GET_STATS_TAG) || !defined(ZC_REQUEST_GET_JOURNAL_TAG)
+#error "zero-control-messages module is older than docs/proto_files/zc_messages.proto"
+#endif
+#endif
+
 struct coap_handler_data {
 	struct coap_resource *res_status;
 	struct bcb_tc_callback trip_callback;
@@ -43,6 +56,11 @@ struct coap_handler_data {
 	pb_ostream_t ostream;
 	zc_message_t zc_msg;
 	uint8_t zc_buffer[ZC_MESSAGE_SIZE];
+	/* Status encoded once per notification round and shared by all the observers. */
+	uint8_t status_buffer[ZC_MESSAGE_SIZE];
+	size_t status_len;
+	uint32_t status_round;
+	bool is_status_valid;
 };
 
 static struct coap_handler_data handler_data;
@@ -196,9 +214,29 @@ static inline void encode_status(zc_status_t *status)
 	status->temp[3].value = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_OUT);
 }
 
-static int send_notification_status(struct sockaddr *addr, uint8_t type, uint16_t id,
-				    uint8_t *token, uint8_t token_len, bool notify,
-				    uint32_t obs_seq)
+static int encode_status_payload(uint8_t *buffer, size_t size, size_t *len)
+{
+	memset(&handler_data.zc_msg, 0, sizeof(handler_data.zc_msg));
+
+	handler_data.zc_msg.which_msg = ZC_MESSAGE_RES_TAG;
+	handler_data.zc_msg.msg.res.which_res = ZC_RESPONSE_STATUS_TAG;
+
+	encode_status(&handler_data.zc_msg.msg.res.res.status);
+
+	handler_data.ostream = pb_ostream_from_buffer(buffer, size);
+	if (!pb_encode(&handler_data.ostream, ZC_MESSAGE_FIELDS, &handler_data.zc_msg)) {
+		LOG_ERR("cannot encode status %s", handler_data.ostream.errmsg);
+		return -EINVAL;
+	}
+
+	*len = handler_data.ostream.bytes_written;
+
+	return 0;
+}
+
+static int send_status(struct sockaddr *addr, uint8_t type, uint16_t id, uint8_t *token,
+		       uint8_t token_len, bool notify, uint32_t obs_seq, const uint8_t *payload,
+		       size_t payload_len)
 {
 	int r;
 	uint16_t format;
@@ -229,27 +267,28 @@ static int send_notification_status(struct sockaddr *addr, uint8_t type, uint16_
 		return r;
 	}
 
-	memset(&handler_data.zc_msg, 0, sizeof(handler_data.zc_msg));
-
-	handler_data.zc_msg.which_msg = ZC_MESSAGE_RES_TAG;
-	handler_data.zc_msg.msg.res.which_res = ZC_RESPONSE_STATUS_TAG;
+	r = coap_packet_append_payload(&handler_data.response, (uint8_t *)payload, payload_len);
+	if (r < 0) {
+		return r;
+	}
 
-	encode_status(&handler_data.zc_msg.msg.res.res.status);
+	return bcb_coap_send_response(&handler_data.response, addr);
+}
 
-	handler_data.ostream =
-		pb_ostream_from_buffer(handler_data.zc_buffer, sizeof(handler_data.zc_buffer));
-	if (!pb_encode(&handler_data.ostream, ZC_MESSAGE_FIELDS, &handler_data.zc_msg)) {
-		LOG_ERR("cannot encode version %s", handler_data.ostream.errmsg);
-		return -EINVAL;
-	}
+static int send_notification_status(struct sockaddr *addr, uint8_t type, uint16_t id,
+				    uint8_t *token, uint8_t token_len, bool notify,
+				    uint32_t obs_seq)
+{
+	size_t len;
+	int r;
 
-	r = coap_packet_append_payload(&handler_data.response, handler_data.zc_buffer,
-				       handler_data.ostream.bytes_written);
-	if (r < 0) {
+	r = encode_status_payload(handler_data.zc_buffer, sizeof(handler_data.zc_buffer), &len);
+	if (r) {
 		return r;
 	}
 
-	return bcb_coap_send_response(&handler_data.response, addr);
+	return send_status(addr, type, id, token, token_len, notify, obs_seq,
+			   handler_data.zc_buffer, len);
 }
 
 static int send_error_status(struct sockaddr *addr, uint8_t type, int error)
@@ -378,8 +417,10 @@ int bcb_coap_handlers_status_post(struct coap_resource *resource, struct coap_pa
 void bcb_coap_handlers_status_notify(struct coap_resource *resource, struct coap_observer *observer)
 {
 	struct bcb_coap_notifier *notifier = bcb_coap_get_notifier(resource, observer);
+	uint32_t round = bcb_coap_get_notify_round();
 	bool pending;
 	uint8_t type;
+	int r;
 
 	if (!notifier) {
 		return;
@@ -407,8 +448,20 @@ void bcb_coap_handlers_status_notify(struct coap_resource *resource, struct coap
 
 	notifier->seq++;
 
-	send_notification_status(&observer->addr, type, coap_next_id(), observer->token,
-				 observer->tkl, true, notifier->seq);
+	/* Only the header differs between the observers of a round. */
+	if (!handler_data.is_status_valid || handler_data.status_round != round) {
+		r = encode_status_payload(handler_data.status_buffer,
+					  sizeof(handler_data.status_buffer),
+					  &handler_data.status_len);
+		if (r) {
+			return;
+		}
+		handler_data.status_round = round;
+		handler_data.is_status_valid = true;
+	}
+
+	send_status(&observer->addr, type, coap_next_id(), observer->token, observer->tkl, true,
+		    notifier->seq, handler_data.status_buffer, handler_data.status_len);
 }
 
 static inline void encode_config_curve(zc_curve_config_t *config)
@@ -442,6 +495,18 @@ static inline void encode_config_csom_mod(zc_csom_mod_config_t *config)
 	config->period = mod_config.zdc_period;
 }
 
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+static inline void encode_config_csom_sd(zc_csom_sd_config_t *config)
+{
+	bcb_tc_def_csom_sd_config_t sd_config;
+
+	bcb_tc_def_csom_sd_config_get(&sd_config);
+
+	config->closed = sd_config.zdc_closed;
+	config->period = sd_config.zdc_period;
+}
+#endif
+
 static inline void encode_config_csom(zc_csom_config_t *config)
 {
 	bcb_tc_def_msm_config_t msm_config;
@@ -451,8 +516,16 @@ static inline void encode_config_csom(zc_csom_config_t *config)
 	switch (msm_config.csom) {
 	case BCB_TC_DEF_MSM_CSOM_MOD: {
 		config->enabled = true;
+		config->which_config = ZC_CSOM_CONFIG_MOD_TAG;
 		encode_config_csom_mod(&config->config.mod);
 	} break;
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+	case BCB_TC_DEF_MSM_CSOM_SD: {
+		config->enabled = true;
+		config->which_config = ZC_CSOM_CONFIG_SD_TAG;
+		encode_config_csom_sd(&config->config.sd);
+	} break;
+#endif
 	default:
 		config->enabled = false;
 		break;
@@ -470,6 +543,11 @@ static inline void encode_config_ocp(zc_ocp_hw_config_t *config)
 	config->rec_attempts = msm_config.rec_attempts;
 	config->rec_delay = msm_config.rec_delay;
 	config->rec_reset_timeout = msm_config.rec_reset_timeout;
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+	config->rec_policy = msm_config.rec_policy == BCB_TC_DEF_MSM_REC_POLICY_BACKOFF ?
+				     ZC_REC_POLICY_BACKOFF :
+				     ZC_REC_POLICY_FIXED;
+#endif
 }
 
 static inline void encode_config_ini_state(zc_ini_state_config_t *config)
@@ -607,6 +685,22 @@ static inline int apply_config_csom_mod(zc_csom_mod_config_t *config)
 	return bcb_tc_def_csom_mod_config_set(&mod_config);
 }
 
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+static inline int apply_config_csom_sd(zc_csom_sd_config_t *config)
+{
+	bcb_tc_def_csom_sd_config_t sd_config;
+
+	if (config->closed > UINT16_MAX || config->period > UINT16_MAX) {
+		return -EINVAL;
+	}
+
+	sd_config.zdc_closed = config->closed;
+	sd_config.zdc_period = config->period;
+
+	return bcb_tc_def_csom_sd_config_set(&sd_config);
+}
+#endif
+
 static inline int apply_config_csom(zc_csom_config_t *config)
 {
 	int r = 0;
@@ -620,6 +714,12 @@ static inline int apply_config_csom(zc_csom_config_t *config)
 			msm_config.csom = BCB_TC_DEF_MSM_CSOM_MOD;
 			r = apply_config_csom_mod(&config->config.mod);
 			break;
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+		case ZC_CSOM_CONFIG_SD_TAG:
+			msm_config.csom = BCB_TC_DEF_MSM_CSOM_SD;
+			r = apply_config_csom_sd(&config->config.sd);
+			break;
+#endif
 		default:
 			r = -ENOTSUP;
 			break;
@@ -647,6 +747,11 @@ static inline int apply_config_ocp(zc_ocp_hw_config_t *config)
 	msm_config.rec_attempts = config->rec_attempts;
 	msm_config.rec_delay = config->rec_delay;
 	msm_config.rec_reset_timeout = config->rec_reset_timeout;
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+	msm_config.rec_policy = config->rec_policy == ZC_REC_POLICY_BACKOFF ?
+					BCB_TC_DEF_MSM_REC_POLICY_BACKOFF :
+					BCB_TC_DEF_MSM_REC_POLICY_FIXED;
+#endif
 
 	return bcb_tc_def_msm_config_set(&msm_config);
 }
@@ -840,6 +945,331 @@ send_error:
 	return send_error_status(addr, COAP_TYPE_ACK, error);
 }
 
+#ifdef CONFIG_BCB_COAP_MESSAGES_EXT
+static inline int send_stats(struct sockaddr *addr, zc_stats_type_t type)
+{
+	int r;
+	uint16_t format;
+	zc_stats_t *zc_stats;
+	bcb_sw_stats_t stats;
+	uint8_t i;
+
+	/* Statistics types of the protocol are in the same order as the switch ones. */
+	r = bcb_sw_stats_get((bcb_sw_stats_type_t)type, &stats);
+	if (r) {
+		return send_error_status(addr, COAP_TYPE_ACK, r);
+	}
+
+	r = coap_packet_init(&handler_data.response, bcb_coap_response_buffer(),
+			     CONFIG_BCB_COAP_MAX_MSG_LEN, 1, COAP_TYPE_ACK, handler_data.token_len,
+			     handler_data.token, COAP_RESPONSE_CODE_CONTENT, handler_data.id);
+	if (r < 0) {
+		return r;
+	}
+
+	format = htons(COAP_CONTENT_FORMAT_NANOPB);
+	r = coap_packet_append_option(&handler_data.response, COAP_OPTION_CONTENT_FORMAT,
+				      (uint8_t *)&format, sizeof(format));
+	if (r < 0) {
+		return r;
+	}
+
+	r = coap_packet_append_payload_marker(&handler_data.response);
+	if (r < 0) {
+		return r;
+	}
+
+	memset(&handler_data.zc_msg, 0, sizeof(handler_data.zc_msg));
+
+	handler_data.zc_msg.which_msg = ZC_MESSAGE_RES_TAG;
+	handler_data.zc_msg.msg.res.which_res = ZC_RESPONSE_STATS_TAG;
+	zc_stats = &handler_data.zc_msg.msg.res.res.stats;
+
+	zc_stats->type = type;
+	zc_stats->count = stats.count;
+	zc_stats->min = stats.min;
+	zc_stats->max = stats.max;
+	zc_stats->mean = stats.mean;
+	zc_stats->p99 = stats.p99;
+
+	/* Trailing empty buckets are not sent. */
+	for (i = 0; i < BCB_SW_STATS_BUCKETS && i < pb_arraysize(zc_stats_t, buckets); i++) {
+		zc_stats->buckets[i] = stats.buckets[i];
+		if (stats.buckets[i]) {
+			zc_stats->buckets_count = i + 1;
+		}
+	}
+
+	handler_data.ostream =
+		pb_ostream_from_buffer(handler_data.zc_buffer, sizeof(handler_data.zc_buffer));
+	if (!pb_encode(&handler_data.ostream, ZC_MESSAGE_FIELDS, &handler_data.zc_msg)) {
+		LOG_ERR("cannot encode stats %s", handler_data.ostream.errmsg);
+		return -EINVAL;
+	}
+
+	r = coap_packet_append_payload(&handler_data.response, handler_data.zc_buffer,
+				       handler_data.ostream.bytes_written);
+	if (r < 0) {
+		return r;
+	}
+
+	return bcb_coap_send_response(&handler_data.response, addr);
+}
+
+int bcb_coap_handlers_stats_post(struct coap_resource *resource, struct coap_packet *request,
+				 struct sockaddr *addr, socklen_t addr_len)
+{
+	struct coap_option cntnt_fmt_opt;
+	uint16_t format;
+	const uint8_t *payload_data;
+	uint16_t payload_len;
+	int error = 0;
+	int r;
+
+	handler_data.id = coap_header_get_id(request);
+	handler_data.token_len = coap_header_get_token(request, handler_data.token);
+
+	r = coap_find_options(request, COAP_OPTION_CONTENT_FORMAT, &cntnt_fmt_opt, 1);
+	if (r < 0 || r == 0 || cntnt_fmt_opt.len != sizeof(uint16_t)) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	format = (uint16_t)cntnt_fmt_opt.value[0] + ((uint16_t)cntnt_fmt_opt.value[1] << 8);
+	if (format != htons(COAP_CONTENT_FORMAT_NANOPB)) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	payload_data = coap_packet_get_payload(request, &payload_len);
+	if (!payload_data || !payload_len) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	handler_data.istream = pb_istream_from_buffer(payload_data, payload_len);
+
+	memset(&handler_data.zc_msg, 0, sizeof(handler_data.zc_msg));
+
+	if (!pb_decode(&handler_data.istream, ZC_MESSAGE_FIELDS, &handler_data.zc_msg)) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	if (handler_data.zc_msg.which_msg != ZC_MESSAGE_REQ_TAG) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	if (handler_data.zc_msg.msg.req.which_req == ZC_REQUEST_GET_STATS_TAG) {
+		return send_stats(addr, handler_data.zc_msg.msg.req.req.get_stats.type);
+	}
+
+	error = -ENOTSUP;
+
+send_error:
+	return send_error_status(addr, COAP_TYPE_ACK, error);
+}
+
+static enum coap_block_size get_journal_block_size(int block2)
+{
+	enum coap_block_size size = COAP_BLOCK_1024;
+
+	while (size > COAP_BLOCK_16 &&
+	       coap_block_size_to_bytes(size) > CONFIG_BCB_COAP_MAX_MSG_LEN - BLOCK_OVERHEAD) {
+		size--;
+	}
+
+	/* The client may ask for smaller blocks. */
+	if (block2 >= 0) {
+		size = MIN(size, (enum coap_block_size)(block2 & 0x07));
+	}
+
+	return size;
+}
+
+static inline int encode_journal(uint32_t since)
+{
+	zc_journal_t *zc_journal;
+	zc_journal_entry_t *zc_entry;
+	bcb_journal_event_t event;
+	uint32_t first;
+	uint32_t last;
+	uint32_t seq;
+
+	memset(&handler_data.zc_msg, 0, sizeof(handler_data.zc_msg));
+
+	handler_data.zc_msg.which_msg = ZC_MESSAGE_RES_TAG;
+	handler_data.zc_msg.msg.res.which_res = ZC_RESPONSE_JOURNAL_TAG;
+	zc_journal = &handler_data.zc_msg.msg.res.res.journal;
+
+	if (!bcb_journal_get_range(&first, &last)) {
+		zc_journal->first_seq = first;
+		zc_journal->last_seq = last;
+
+		for (seq = since;
+		     zc_journal->entries_count < pb_arraysize(zc_journal_t, entries) &&
+		     !bcb_journal_get_next(seq, &event);
+		     seq = event.seq) {
+			zc_entry = &zc_journal->entries[zc_journal->entries_count++];
+			zc_entry->seq = event.seq;
+			zc_entry->type = (zc_journal_type_t)event.type;
+			zc_entry->uptime = event.uptime;
+			zc_entry->arg = event.arg;
+			zc_entry->value = event.value;
+		}
+	}
+
+	handler_data.ostream =
+		pb_ostream_from_buffer(handler_data.zc_buffer, sizeof(handler_data.zc_buffer));
+	if (!pb_encode(&handler_data.ostream, ZC_MESSAGE_FIELDS, &handler_data.zc_msg)) {
+		LOG_ERR("cannot encode journal %s", handler_data.ostream.errmsg);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * The journal may not fit in a single response, so it is sent block-wise (RFC 7959).
+ * The client repeats the request with the Block2 option for the next blocks and restarts if
+ * the ETag (latest sequence number) changes in between.
+ */
+static inline int send_journal(struct sockaddr *addr, struct coap_packet *request, uint32_t since)
+{
+	enum coap_block_size block_size;
+	uint16_t format;
+	uint32_t etag;
+	uint32_t offset;
+	uint32_t total;
+	uint16_t len;
+	int block2;
+	bool more;
+	int r;
+
+	r = encode_journal(since);
+	if (r) {
+		return send_error_status(addr, COAP_TYPE_ACK, r);
+	}
+
+	block2 = coap_get_option_int(request, COAP_OPTION_BLOCK2);
+	block_size = get_journal_block_size(block2);
+	total = handler_data.ostream.bytes_written;
+	offset = block2 >= 0 ? (block2 >> 4) * coap_block_size_to_bytes(block_size) : 0;
+	if (offset && offset >= total) {
+		return send_error_status(addr, COAP_TYPE_ACK, -EINVAL);
+	}
+
+	len = MIN(total - offset, coap_block_size_to_bytes(block_size));
+	more = offset + len < total;
+
+	r = coap_packet_init(&handler_data.response, bcb_coap_response_buffer(),
+			     CONFIG_BCB_COAP_MAX_MSG_LEN, 1, COAP_TYPE_ACK, handler_data.token_len,
+			     handler_data.token, COAP_RESPONSE_CODE_CONTENT, handler_data.id);
+	if (r < 0) {
+		return r;
+	}
+
+	/* Options have to be appended in the ascending order of their numbers. */
+	etag = htonl(handler_data.zc_msg.msg.res.res.journal.last_seq);
+	r = coap_packet_append_option(&handler_data.response, COAP_OPTION_ETAG, (uint8_t *)&etag,
+				      sizeof(etag));
+	if (r < 0) {
+		return r;
+	}
+
+	format = htons(COAP_CONTENT_FORMAT_NANOPB);
+	r = coap_packet_append_option(&handler_data.response, COAP_OPTION_CONTENT_FORMAT,
+				      (uint8_t *)&format, sizeof(format));
+	if (r < 0) {
+		return r;
+	}
+
+	if (block2 >= 0 || more) {
+		r = coap_append_option_int(&handler_data.response, COAP_OPTION_BLOCK2,
+					   (offset / coap_block_size_to_bytes(block_size)) << 4 |
+						   (more ? 0x08 : 0) | block_size);
+		if (r < 0) {
+			return r;
+		}
+
+		r = coap_append_option_int(&handler_data.response, COAP_OPTION_SIZE2, total);
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	r = coap_packet_append_payload_marker(&handler_data.response);
+	if (r < 0) {
+		return r;
+	}
+
+	r = coap_packet_append_payload(&handler_data.response, &handler_data.zc_buffer[offset],
+				       len);
+	if (r < 0) {
+		return r;
+	}
+
+	return bcb_coap_send_response(&handler_data.response, addr);
+}
+
+int bcb_coap_handlers_journal_post(struct coap_resource *resource, struct coap_packet *request,
+				   struct sockaddr *addr, socklen_t addr_len)
+{
+	struct coap_option cntnt_fmt_opt;
+	uint16_t format;
+	const uint8_t *payload_data;
+	uint16_t payload_len;
+	int error = 0;
+	int r;
+
+	handler_data.id = coap_header_get_id(request);
+	handler_data.token_len = coap_header_get_token(request, handler_data.token);
+
+	r = coap_find_options(request, COAP_OPTION_CONTENT_FORMAT, &cntnt_fmt_opt, 1);
+	if (r < 0 || r == 0 || cntnt_fmt_opt.len != sizeof(uint16_t)) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	format = (uint16_t)cntnt_fmt_opt.value[0] + ((uint16_t)cntnt_fmt_opt.value[1] << 8);
+	if (format != htons(COAP_CONTENT_FORMAT_NANOPB)) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	payload_data = coap_packet_get_payload(request, &payload_len);
+	if (!payload_data || !payload_len) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	handler_data.istream = pb_istream_from_buffer(payload_data, payload_len);
+
+	memset(&handler_data.zc_msg, 0, sizeof(handler_data.zc_msg));
+
+	if (!pb_decode(&handler_data.istream, ZC_MESSAGE_FIELDS, &handler_data.zc_msg)) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	if (handler_data.zc_msg.which_msg != ZC_MESSAGE_REQ_TAG) {
+		error = -EINVAL;
+		goto send_error;
+	}
+
+	if (handler_data.zc_msg.msg.req.which_req == ZC_REQUEST_GET_JOURNAL_TAG) {
+		return send_journal(addr, request,
+				    handler_data.zc_msg.msg.req.req.get_journal.since);
+	}
+
+	error = -ENOTSUP;
+
+send_error:
+	return send_error_status(addr, COAP_TYPE_ACK, error);
+}
+#endif
+
 void bcb_trip_curve_callback(const struct bcb_tc *curve, bcb_tc_cause_t type)
 {
 	if (!handler_data.res_status) {
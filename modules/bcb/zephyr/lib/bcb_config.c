@@ -1,105 +1,1193 @@
 #include <lib/bcb_config.h>
+#include <lib/bcb_journal.h>
 #include <init.h>
+#include <kernel.h>
 #include <drivers/eeprom.h>
+#include <drivers/eeprom_m95080.h>
 #include <sys/crc.h>
+#include <string.h>
 
 #define LOG_LEVEL CONFIG_BCB_CONFIG_LOG_LEVEL
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bcb_config);
 
 #define BCB_CONFIG_EEPROM_LABEL		DT_LABEL(DT_CHOSEN(breaker_config_eeprom))
-#define BCB_CONFIG_MAGIC		0xabcdU
+#define BCB_CONFIG_MAGIC		0xabceU
+/* Records written before the header had an ID and a version */
+#define BCB_CONFIG_LEGACY_MAGIC		0xabcdU
+#define BCB_CONFIG_LOG_MAGIC		0xa5U
+#define BCB_CONFIG_JOURNAL_OFFSET	CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_JOURNAL
+#define BCB_CONFIG_LOG_OFFSET		CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_LOG
+#define BCB_CONFIG_LOG_SIZE		CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_LOG
+#define BCB_CONFIG_LOG_BANK_SIZE	(BCB_CONFIG_LOG_SIZE / 2)
+#define BCB_CONFIG_LOG_RECORD_MAX	CONFIG_BCB_LIB_PERSISTENT_CONFIG_LOG_RECORD_MAX
+#define BCB_CONFIG_PAGE_SIZE		DT_PROP(DT_CHOSEN(breaker_config_eeprom), pagesize)
+/* Fixed offset records are cached up to the start of the log. */
+#define BCB_CONFIG_CACHE_SIZE		BCB_CONFIG_LOG_OFFSET
+#define BCB_CONFIG_CACHE_PAGES		DIV_ROUND_UP(BCB_CONFIG_CACHE_SIZE, BCB_CONFIG_PAGE_SIZE)
+#define BCB_CONFIG_PARTITION_SIZE	(BCB_CONFIG_LOG_OFFSET + BCB_CONFIG_LOG_SIZE)
+#define BCB_CONFIG_FLUSH_DELAY		CONFIG_BCB_LIB_PERSISTENT_CONFIG_FLUSH_DELAY
+#define BCB_CONFIG_FLUSH_MAX_DELAY	CONFIG_BCB_LIB_PERSISTENT_CONFIG_FLUSH_MAX_DELAY
+#define BCB_CONFIG_SCRUB_INTERVAL	CONFIG_BCB_LIB_PERSISTENT_CONFIG_SCRUB_INTERVAL
+
+BUILD_ASSERT(BCB_CONFIG_CACHE_PAGES <= 32, "Dirty page mask is too small");
+
+#if defined(CONFIG_EEPROM_M95080) &&                                                               \
+	DT_NODE_HAS_COMPAT(DT_CHOSEN(breaker_config_eeprom), st_m95080)
+/* Pages are queued to the driver, which waits for their write cycles with a timer. */
+#define BCB_CONFIG_EEPROM_ASYNC
+/* The driver serves small reads from its page cache, which the checks have to bypass. */
+#define BCB_CONFIG_EEPROM_UNCACHED
+#endif
+
+#define BCB_CONFIG_REGION(name)                                                                    \
+	{                                                                                          \
+		.offset = CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name,                          \
+		.size = CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_##name,                              \
+	}
+
+/* Regions with a redundant copy of the same size; the copy is disabled with offset 0. */
+#define BCB_CONFIG_REGION_AB(name)                                                                 \
+	{                                                                                          \
+		.offset = CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name,                          \
+		.size = CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_##name,                              \
+		.offset_b = CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name##_B,                    \
+	}
+
+#define BCB_CONFIG_REGION_END(name)                                                                \
+	(CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name +                                          \
+	 CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_##name)
+
+/* Regions are checked in the order they are laid out, followed by the log. */
+#define BCB_CONFIG_REGION_ASSERT_BEFORE(a, b)                                                      \
+	BUILD_ASSERT(BCB_CONFIG_REGION_END(a) <= CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##b,      \
+		     "Persistent configuration " #a " overlaps " #b)
+
+/* A copy starts in a page after its main record, so that the main record is always flushed first
+ * and a torn page write cannot damage both.
+ */
+#define BCB_CONFIG_REGION_ASSERT_COPY(name, next)                                                  \
+	BUILD_ASSERT(!CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name##_B ||                         \
+			     (ROUND_DOWN(CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name##_B,       \
+					 BCB_CONFIG_PAGE_SIZE) >= BCB_CONFIG_REGION_END(name) &&   \
+			      CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_##name##_B +                 \
+					      CONFIG_BCB_LIB_PERSISTENT_CONFIG_SIZE_##name <=      \
+				      (next)),                                                     \
+		     "Invalid copy of persistent configuration " #name)
+
+BCB_CONFIG_REGION_ASSERT_BEFORE(IDENTITY, MSMNT);
+BCB_CONFIG_REGION_ASSERT_COPY(IDENTITY, BCB_CONFIG_JOURNAL_OFFSET);
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT
+BCB_CONFIG_REGION_ASSERT_BEFORE(MSMNT, TC_DEF);
+BCB_CONFIG_REGION_ASSERT_COPY(MSMNT, CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_TC_DEF);
+BCB_CONFIG_REGION_ASSERT_BEFORE(TC_DEF, TC_DEF_MSM);
+BCB_CONFIG_REGION_ASSERT_BEFORE(TC_DEF_MSM, TC_DEF_CSOM_SD);
+BCB_CONFIG_REGION_ASSERT_BEFORE(TC_DEF_CSOM_SD, TC_DEF_CSOM_MOD);
+BCB_CONFIG_REGION_ASSERT_BEFORE(TC_DEF_CSOM_MOD, JOURNAL);
+#else
+BCB_CONFIG_REGION_ASSERT_BEFORE(MSMNT, JOURNAL);
+BCB_CONFIG_REGION_ASSERT_COPY(MSMNT, BCB_CONFIG_JOURNAL_OFFSET);
+#endif
+/* The journal is cached and flushed with the fixed offset records. */
+BCB_CONFIG_REGION_ASSERT_BEFORE(JOURNAL, LOG);
+BUILD_ASSERT(BCB_CONFIG_JOURNAL_OFFSET % BCB_CONFIG_JOURNAL_SLOT_SIZE == 0 &&
+		     BCB_CONFIG_PAGE_SIZE % BCB_CONFIG_JOURNAL_SLOT_SIZE == 0,
+	     "Journal slots must not straddle EEPROM pages");
+BUILD_ASSERT(BCB_CONFIG_REGION_END(LOG) <= DT_PROP(DT_CHOSEN(breaker_config_eeprom), size),
+	     "Persistent configurations do not fit in the EEPROM");
+
+struct config_region {
+	uint16_t offset;
+	uint16_t size;
+	uint16_t offset_b; /* Redundant copy, 0 if none */
+};
+
+/* Regions of disabled modules have no size. */
+static const struct config_region config_regions[BCB_CONFIG_ID_END] = {
+	[BCB_CONFIG_ID_IDENTITY] = BCB_CONFIG_REGION_AB(IDENTITY),
+	[BCB_CONFIG_ID_MSMNT] = BCB_CONFIG_REGION_AB(MSMNT),
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT
+	[BCB_CONFIG_ID_TC_DEF] = BCB_CONFIG_REGION(TC_DEF),
+	[BCB_CONFIG_ID_TC_DEF_MSM] = BCB_CONFIG_REGION(TC_DEF_MSM),
+	[BCB_CONFIG_ID_TC_DEF_CSOM_MOD] = BCB_CONFIG_REGION(TC_DEF_CSOM_MOD),
+	[BCB_CONFIG_ID_TC_DEF_CSOM_SD] = BCB_CONFIG_REGION(TC_DEF_CSOM_SD),
+#endif
+};
+
+/* Latest valid copy of a log record. */
+struct config_log_entry {
+	uint16_t offset;
+	uint32_t seq;
+	uint8_t version;
+	uint8_t size;
+	bool is_valid;
+};
+
+/* RAM copy of the latest log record, so that loading never reads the EEPROM. */
+struct config_log_cache {
+	uint8_t data[BCB_CONFIG_LOG_RECORD_MAX];
+	uint8_t version;
+	uint8_t size;
+	bool is_valid;
+	bool is_dirty; /* Not flushed yet */
+};
+
+#ifdef BCB_CONFIG_EEPROM_ASYNC
+struct config_page_write {
+	struct eeprom_m95080_request req;
+	int result;
+};
+#endif
 
 struct bcb_config_data {
 	struct device *dev_eeprom;
+	struct k_mutex cache_lock; /* Protects the caches. */
+	struct k_mutex flush_lock; /* Serialises EEPROM writes and protects the log state. */
+	uint8_t cache[BCB_CONFIG_CACHE_SIZE];
+	uint32_t cache_dirty; /* One bit per page */
+	struct config_log_cache log_cache[BCB_CONFIG_LOG_ID_END];
+	uint8_t flush_buffer[MAX(BCB_CONFIG_PAGE_SIZE, BCB_CONFIG_LOG_RECORD_MAX)];
+#ifdef BCB_CONFIG_EEPROM_ASYNC
+	uint8_t flush_pages[BCB_CONFIG_CACHE_SIZE]; /* Dirty pages while they are written */
+	struct config_page_write page_writes[BCB_CONFIG_CACHE_PAGES];
+	struct k_sem page_writes_done;
+#endif
+	struct k_work_q flush_work_q;
+	struct k_delayed_work flush_work;
+	int64_t flush_deadline; /* Uptime by which the flush must run, 0 if nothing waits for it */
+	struct config_log_entry log_index[BCB_CONFIG_LOG_ID_END];
+	uint16_t log_head;
+	uint8_t log_bank;
+	uint32_t log_seq;
+	uint8_t log_buffer[BCB_CONFIG_LOG_RECORD_MAX];
+	struct k_delayed_work scrub_work;
+	bool is_loaded; /* The cache holds the EEPROM contents */
+	bcb_config_scrub_stats_t scrub_stats; /* Protected by the cache lock */
 };
 
+/* CRC covers the header up to the CRC and the payload. */
 struct __attribute__((packed)) config_header {
+	uint16_t magic;
+	uint8_t id;
+	uint8_t version;
+	uint16_t size;
+	uint16_t crc;
+};
+
+/* CRC covers the payload only. */
+struct __attribute__((packed)) config_legacy_header {
 	uint16_t magic;
 	uint16_t size;
 	uint16_t crc;
 };
 
+/* CRC covers the header up to the CRC and the payload. */
+struct __attribute__((packed)) config_log_header {
+	uint8_t magic;
+	uint8_t id;
+	uint32_t seq; /* Never wraps in the lifetime of the EEPROM. */
+	uint8_t version;
+	uint8_t size;
+	uint16_t crc;
+};
+
+#define BCB_CONFIG_HEADER_CRC_SIZE	offsetof(struct config_header, crc)
+#define BCB_CONFIG_LOG_HEADER_CRC_SIZE	offsetof(struct config_log_header, crc)
+#define BCB_CONFIG_LOG_LIVE_SIZE                                                                   \
+	(BCB_CONFIG_LOG_ID_END * BCB_CONFIG_LOG_HEADER_SIZE + BCB_CONFIG_LOG_SIZE_BCB +            \
+	 BCB_CONFIG_LOG_SIZE_TC_DEF_OCPT + BCB_CONFIG_LOG_SIZE_TC_DEF_SNAPSHOT)
+
+BUILD_ASSERT(sizeof(struct config_header) == BCB_CONFIG_HEADER_SIZE, "Invalid header size");
+BUILD_ASSERT(sizeof(struct config_log_header) == BCB_CONFIG_LOG_HEADER_SIZE,
+	     "Invalid log header size");
+/* A compaction copies the live records into the other bank. A quarter of the bank is left for
+ * the appends that follow, otherwise almost every store would compact the log.
+ */
+BUILD_ASSERT(BCB_CONFIG_LOG_LIVE_SIZE <= BCB_CONFIG_LOG_BANK_SIZE * 3 / 4,
+	     "Log-structured records leave too little room in a bank");
+BUILD_ASSERT(BCB_CONFIG_FLUSH_MAX_DELAY >= BCB_CONFIG_FLUSH_DELAY,
+	     "Maximum flush delay must not be shorter than the flush delay");
+
 static struct bcb_config_data config_data;
 
-int bcb_config_load(off_t offset, uint8_t *data, size_t size)
+K_THREAD_STACK_DEFINE(config_flush_stack, CONFIG_BCB_LIB_PERSISTENT_CONFIG_FLUSH_STACK_SIZE);
+
+/*
+ * Re-submitting restarts the delay, so a burst of updates is written once. The delay is capped by
+ * the deadline set by the first update that has not been flushed.
+ */
+static void config_flush_schedule(int32_t delay)
+{
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	if (!config_data.flush_deadline) {
+		config_data.flush_deadline = now + BCB_CONFIG_FLUSH_MAX_DELAY;
+	}
+	delay = MAX(0, MIN(delay, config_data.flush_deadline - now));
+	k_mutex_unlock(&config_data.cache_lock);
+
+	k_delayed_work_submit_to_queue(&config_data.flush_work_q, &config_data.flush_work,
+				       K_MSEC(delay));
+}
+
+/* On failure data is left as it is. */
+static int config_migrate(uint8_t stored_version, const uint8_t *stored, size_t stored_size,
+			  uint8_t version, uint8_t *data, size_t size, bcb_config_migrate_t migrate)
 {
+	uint8_t *buf;
 	int r;
-	struct config_header header;
 
+	if (stored_version == version) {
+		if (stored_size != size) {
+			LOG_ERR("Invalid size: %zu", stored_size);
+			return -EINVAL;
+		}
+
+		memcpy(data, stored, size);
+		return 0;
+	}
+
+	if (stored_version > version) {
+		LOG_ERR("Unsupported version: %d", stored_version);
+		return -ENOTSUP;
+	}
+
+	if (!migrate) {
+		/* Fields are only appended, so an older record is a prefix of the current one. */
+		if (stored_size > size) {
+			LOG_ERR("Invalid size: %zu", stored_size);
+			return -EINVAL;
+		}
+
+		memcpy(data, stored, stored_size);
+		return 0;
+	}
+
+	buf = k_malloc(size);
+	if (!buf) {
+		return -ENOMEM;
+	}
+
+	memcpy(buf, data, size);
+	r = migrate(stored_version, stored, stored_size, buf, size);
+	if (!r) {
+		memcpy(data, buf, size);
+	}
+
+	k_free(buf);
+
+	return r;
+}
+
+static int config_region_check(bcb_config_id_t id, size_t size)
+{
 	if (!config_data.dev_eeprom) {
 		LOG_ERR("Could not get EEPROM device");
 		return -ENOENT;
 	}
 
-	r = eeprom_read(config_data.dev_eeprom, offset, &header, sizeof(header));
-	if (r) {
-		LOG_ERR("Cannot read EEPROM: %d", r);
-		return r;
+	if (id >= BCB_CONFIG_ID_END || !config_regions[id].size) {
+		return -ENOENT;
 	}
 
-	if (header.magic != BCB_CONFIG_MAGIC) {
-		LOG_ERR("Invalid magic: 0x%04x", header.magic);
+	if (sizeof(struct config_header) + size > config_regions[id].size) {
 		return -EINVAL;
 	}
 
-	if (size != header.size) {
-		LOG_ERR("Invalid size: %d", header.size);
-		return -EINVAL;
+	return 0;
+}
+
+/* Must be called with the cache locked. */
+static void config_cache_mark_dirty(uint16_t offset, size_t size)
+{
+	size_t page;
+
+	for (page = offset / BCB_CONFIG_PAGE_SIZE;
+	     page <= (offset + size - 1) / BCB_CONFIG_PAGE_SIZE; page++) {
+		config_data.cache_dirty |= BIT(page);
 	}
+}
 
-	offset += sizeof(header);
-	r = eeprom_read(config_data.dev_eeprom, offset, data, size);
-	if (r) {
-		LOG_ERR("Cannot read EEPROM: %d", r);
-		return r;
+/* Must be called with the cache locked. Returns -ENOENT if there is no record at all. */
+static int config_record_check(bcb_config_id_t id, uint16_t offset, const uint8_t **stored,
+			       uint16_t *stored_size, uint8_t *stored_version)
+{
+	struct config_legacy_header legacy;
+	struct config_header header;
+	uint8_t *record = &config_data.cache[offset];
+	uint16_t region_size = config_regions[id].size;
+	uint16_t crc;
+
+	memcpy(&header, record, sizeof(header));
+	memcpy(&legacy, record, sizeof(legacy));
+
+	if (header.magic == BCB_CONFIG_MAGIC) {
+		*stored = record + sizeof(header);
+		*stored_size = header.size;
+		*stored_version = header.version;
+		if (header.id != id || sizeof(header) + header.size > region_size) {
+			return -EINVAL;
+		}
+
+		crc = crc16_ccitt(0, (uint8_t *)&header, BCB_CONFIG_HEADER_CRC_SIZE);
+		crc = crc16_ccitt(crc, *stored, *stored_size);
+	} else if (legacy.magic == BCB_CONFIG_LEGACY_MAGIC) {
+		*stored = record + sizeof(legacy);
+		*stored_size = legacy.size;
+		*stored_version = 0;
+		header.crc = legacy.crc;
+		if (sizeof(legacy) + legacy.size > region_size) {
+			return -EINVAL;
+		}
+
+		crc = crc16_ccitt(0, *stored, *stored_size);
+	} else {
+		return -ENOENT;
+	}
+
+	return header.crc == crc ? 0 : -EINVAL;
+}
+
+/*
+ * Must be called with the cache locked. Makes the redundant copy of a record the same as the
+ * main one. The main copy is flushed first, so it is the latest one when both are valid.
+ * Returns 1 if a corrupted copy has been repaired, -EINVAL if neither copy is valid.
+ */
+static int config_copies_sync(bcb_config_id_t id)
+{
+	const struct config_region *region = &config_regions[id];
+	const uint8_t *stored;
+	uint16_t stored_size;
+	uint8_t stored_version;
+	uint16_t from;
+	uint16_t to;
+	int r_b;
+	int r;
+
+	if (!region->offset_b) {
+		return 0;
 	}
 
-	if (header.crc != crc16_ccitt(0, data, size)) {
-		LOG_ERR("Invalid CRC");
+	r = config_record_check(id, region->offset, &stored, &stored_size, &stored_version);
+	r_b = config_record_check(id, region->offset_b, &stored, &stored_size, &stored_version);
+
+	if (!r) {
+		if (!memcmp(&config_data.cache[region->offset], &config_data.cache[region->offset_b],
+			    region->size)) {
+			return 0;
+		}
+		from = region->offset;
+		to = region->offset_b;
+	} else if (!r_b) {
+		LOG_WRN("Restoring record %d from its copy", id);
+		from = region->offset_b;
+		to = region->offset;
+	} else if (r == -ENOENT && r_b == -ENOENT) {
+		/* Never stored */
+		return 0;
+	} else {
+		LOG_ERR("Both copies of record %d are invalid", id);
+		config_data.scrub_stats.errors++;
+		config_data.scrub_stats.failures++;
 		return -EINVAL;
 	}
 
+	memcpy(&config_data.cache[to], &config_data.cache[from], region->size);
+	config_cache_mark_dirty(to, region->size);
+
+	/* An outdated copy is left by a power loss between writing the two copies, and there is no
+	 * copy at all after an upgrade. Neither is an error. */
+	if (r || r_b == -EINVAL) {
+		config_data.scrub_stats.errors++;
+		config_data.scrub_stats.repairs++;
+		return 1;
+	}
+
 	return 0;
 }
 
-int bcb_config_store(off_t offset, uint8_t *data, size_t size)
+int bcb_config_load(bcb_config_id_t id, uint8_t version, uint8_t *data, size_t size,
+		    bcb_config_migrate_t migrate)
 {
+	const uint8_t *stored;
+	uint16_t stored_size;
+	uint8_t stored_version;
+	bool is_repaired;
 	int r;
+
+	r = config_region_check(id, size);
+	if (r) {
+		return r;
+	}
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+
+	is_repaired = config_copies_sync(id) > 0;
+
+	r = config_record_check(id, config_regions[id].offset, &stored, &stored_size,
+				&stored_version);
+	if (r == -ENOENT) {
+		LOG_ERR("Invalid magic in record %d", id);
+		r = -EINVAL;
+	} else if (r) {
+		LOG_ERR("Invalid record %d", id);
+	} else {
+		r = config_migrate(stored_version, stored, stored_size, version, data, size,
+				   migrate);
+	}
+
+	k_mutex_unlock(&config_data.cache_lock);
+
+	/* The repaired copy is only in the cache until it is flushed. */
+	if (is_repaired) {
+		config_flush_schedule(BCB_CONFIG_FLUSH_DELAY);
+	}
+
+	if (!r && stored_version != version) {
+		LOG_INF("Migrating record %d from version %d to %d", id, stored_version, version);
+		r = bcb_config_store(id, version, data, size);
+	}
+
+	return r;
+}
+
+int bcb_config_store(bcb_config_id_t id, uint8_t version, uint8_t *data, size_t size)
+{
 	struct config_header header;
+	off_t offset;
+	int r;
 
-	if (!config_data.dev_eeprom) {
-		LOG_ERR("Could not get EEPROM device");
-		return -ENOENT;
+	r = config_region_check(id, size);
+	if (r) {
+		return r;
 	}
 
+	offset = config_regions[id].offset;
+
 	header.magic = BCB_CONFIG_MAGIC;
+	header.id = id;
+	header.version = version;
+	header.size = size;
+	header.crc = crc16_ccitt(0, (uint8_t *)&header, BCB_CONFIG_HEADER_CRC_SIZE);
+	header.crc = crc16_ccitt(header.crc, data, size);
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+
+	memcpy(&config_data.cache[offset], &header, sizeof(header));
+	memcpy(&config_data.cache[offset + sizeof(header)], data, size);
+	config_cache_mark_dirty(offset, sizeof(header) + size);
+
+	offset = config_regions[id].offset_b;
+	if (offset) {
+		memcpy(&config_data.cache[offset], &header, sizeof(header));
+		memcpy(&config_data.cache[offset + sizeof(header)], data, size);
+		config_cache_mark_dirty(offset, sizeof(header) + size);
+	}
+
+	k_mutex_unlock(&config_data.cache_lock);
+
+	bcb_journal_add(BCB_JOURNAL_TYPE_CONFIG, id, version);
+
+	config_flush_schedule(BCB_CONFIG_FLUSH_DELAY);
+
+	return 0;
+}
+
+static inline uint8_t log_bank_of(uint16_t offset)
+{
+	return offset / BCB_CONFIG_LOG_BANK_SIZE;
+}
+
+static inline uint16_t log_bank_end(uint8_t bank)
+{
+	return (bank + 1) * BCB_CONFIG_LOG_BANK_SIZE;
+}
+
+static int log_write(uint8_t id, uint8_t version, const uint8_t *data, uint8_t size)
+{
+	struct config_log_header header;
+	uint16_t offset = config_data.log_head;
+	int r;
+
+	header.magic = BCB_CONFIG_LOG_MAGIC;
+	header.id = id;
+	header.seq = config_data.log_seq + 1;
+	header.version = version;
 	header.size = size;
-	header.crc = crc16_ccitt(0, data, size);
+	header.crc = crc16_ccitt(0, (uint8_t *)&header, BCB_CONFIG_LOG_HEADER_CRC_SIZE);
+	header.crc = crc16_ccitt(header.crc, data, size);
 
-	r = eeprom_write(config_data.dev_eeprom, offset, &header, sizeof(header));
+	/* A torn write leaves a record with an invalid CRC, hence the previous copy is still the
+	 * latest valid one. */
+	r = eeprom_write(config_data.dev_eeprom, BCB_CONFIG_LOG_OFFSET + offset, &header,
+			 sizeof(header));
 	if (r) {
-		LOG_ERR("Cannot write EEPROM: %d", r);
 		return r;
 	}
 
-	offset += sizeof(header);
-	r = eeprom_write(config_data.dev_eeprom, offset, data, size);
+	r = eeprom_write(config_data.dev_eeprom, BCB_CONFIG_LOG_OFFSET + offset + sizeof(header),
+			 data, size);
 	if (r) {
-		LOG_ERR("Cannot write EEPROM: %d", r);
 		return r;
 	}
 
+	config_data.log_seq = header.seq;
+	config_data.log_head = offset + sizeof(header) + size;
+	config_data.log_index[id].offset = offset;
+	config_data.log_index[id].seq = header.seq;
+	config_data.log_index[id].version = version;
+	config_data.log_index[id].size = size;
+	config_data.log_index[id].is_valid = true;
+
+	return 0;
+}
+
+static inline int config_read_uncached(off_t offset, void *data, size_t size)
+{
+#ifdef BCB_CONFIG_EEPROM_UNCACHED
+	return eeprom_m95080_read_uncached(config_data.dev_eeprom, offset, data, size);
+#else
+	return eeprom_read(config_data.dev_eeprom, offset, data, size);
+#endif
+}
+
+/* Reads the stored size of the record, which is at most BCB_CONFIG_LOG_RECORD_MAX. */
+static int log_read(uint8_t id, uint8_t *data)
+{
+	struct config_log_entry *entry = &config_data.log_index[id];
+	struct config_log_header header;
+	uint8_t size = entry->size;
+	uint16_t crc;
+	int r;
+
+	r = config_read_uncached(BCB_CONFIG_LOG_OFFSET + entry->offset, &header, sizeof(header));
+	if (r) {
+		return r;
+	}
+
+	r = config_read_uncached(BCB_CONFIG_LOG_OFFSET + entry->offset + sizeof(header), data,
+				 size);
+	if (r) {
+		return r;
+	}
+
+	crc = crc16_ccitt(0, (uint8_t *)&header, BCB_CONFIG_LOG_HEADER_CRC_SIZE);
+	crc = crc16_ccitt(crc, data, size);
+	if (header.magic != BCB_CONFIG_LOG_MAGIC || header.id != id ||
+	    header.version != entry->version || header.size != size || header.crc != crc) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int log_relocate(uint8_t id)
+{
+	struct config_log_entry *entry = &config_data.log_index[id];
+	int r;
+
+	r = log_read(id, config_data.log_buffer);
+	if (r) {
+		LOG_ERR("Cannot relocate record %d: %d", id, r);
+		entry->is_valid = false;
+		return 0;
+	}
+
+	return log_write(id, entry->version, config_data.log_buffer, entry->size);
+}
+
+/* Move the latest copies of all records but the one about to be replaced to the start of the
+ * other bank, so that a bank only needs to hold one copy of each record. The current bank is not
+ * written until the next compaction, so it still holds every record if this is interrupted.
+ */
+static int log_compact(uint8_t skip_id)
+{
+	uint8_t bank = config_data.log_bank;
+	uint8_t id;
+	int r;
+
+	config_data.log_bank = bank ^ 1;
+	config_data.log_head = config_data.log_bank * BCB_CONFIG_LOG_BANK_SIZE;
+	LOG_DBG("compacting to bank %d", config_data.log_bank);
+
+	for (id = 0; id < BCB_CONFIG_LOG_ID_END; id++) {
+		if (id == skip_id || !config_data.log_index[id].is_valid ||
+		    log_bank_of(config_data.log_index[id].offset) != bank) {
+			continue;
+		}
+
+		r = log_relocate(id);
+		if (r) {
+			return r;
+		}
+	}
+
+	return 0;
+}
+
+int bcb_config_log_load(bcb_config_log_id_t id, uint8_t version, uint8_t *data, size_t size,
+			bcb_config_migrate_t migrate)
+{
+	struct config_log_cache *cache;
+	uint8_t stored_version;
+	int r;
+
+	if (!config_data.dev_eeprom) {
+		LOG_ERR("Could not get EEPROM device");
+		return -ENOENT;
+	}
+
+	if (id >= BCB_CONFIG_LOG_ID_END) {
+		return -EINVAL;
+	}
+
+	cache = &config_data.log_cache[id];
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+
+	stored_version = cache->version;
+	if (!cache->is_valid) {
+		r = -ENOENT;
+	} else {
+		r = config_migrate(cache->version, cache->data, cache->size, version, data, size,
+				   migrate);
+	}
+
+	k_mutex_unlock(&config_data.cache_lock);
+
+	if (!r && stored_version != version) {
+		LOG_INF("Migrating log record %d from version %d to %d", id, stored_version,
+			version);
+		r = bcb_config_log_store(id, version, data, size);
+	}
+
+	return r;
+}
+
+static int log_append(uint8_t id, uint8_t version, const uint8_t *data, uint8_t size)
+{
+	uint16_t length = sizeof(struct config_log_header) + size;
+	int r;
+
+	if (config_data.log_head + length > log_bank_end(config_data.log_bank)) {
+		r = log_compact(id);
+		if (r) {
+			return r;
+		}
+	}
+
+	if (config_data.log_head + length > log_bank_end(config_data.log_bank)) {
+		LOG_ERR("Log is full");
+		return -ENOSPC;
+	}
+
+	return log_write(id, version, data, size);
+}
+
+int bcb_config_log_store(bcb_config_log_id_t id, uint8_t version, uint8_t *data, size_t size)
+{
+	if (!config_data.dev_eeprom) {
+		LOG_ERR("Could not get EEPROM device");
+		return -ENOENT;
+	}
+
+	if (id >= BCB_CONFIG_LOG_ID_END || size > BCB_CONFIG_LOG_RECORD_MAX) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	memcpy(config_data.log_cache[id].data, data, size);
+	config_data.log_cache[id].version = version;
+	config_data.log_cache[id].size = size;
+	config_data.log_cache[id].is_valid = true;
+	config_data.log_cache[id].is_dirty = true;
+	k_mutex_unlock(&config_data.cache_lock);
+
+	config_flush_schedule(BCB_CONFIG_FLUSH_DELAY);
+
+	return 0;
+}
+
+int bcb_config_journal_load(uint8_t slot, uint8_t *data)
+{
+	off_t offset = BCB_CONFIG_JOURNAL_OFFSET + slot * BCB_CONFIG_JOURNAL_SLOT_SIZE;
+
+	if (!config_data.dev_eeprom) {
+		LOG_ERR("Could not get EEPROM device");
+		return -ENOENT;
+	}
+
+	if (slot >= BCB_CONFIG_JOURNAL_SLOTS) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	memcpy(data, &config_data.cache[offset], BCB_CONFIG_JOURNAL_SLOT_SIZE);
+	k_mutex_unlock(&config_data.cache_lock);
+
+	return 0;
+}
+
+int bcb_config_journal_store(uint8_t slot, const uint8_t *data)
+{
+	off_t offset = BCB_CONFIG_JOURNAL_OFFSET + slot * BCB_CONFIG_JOURNAL_SLOT_SIZE;
+
+	if (!config_data.dev_eeprom) {
+		LOG_ERR("Could not get EEPROM device");
+		return -ENOENT;
+	}
+
+	if (slot >= BCB_CONFIG_JOURNAL_SLOTS) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	memcpy(&config_data.cache[offset], data, BCB_CONFIG_JOURNAL_SLOT_SIZE);
+	config_cache_mark_dirty(offset, BCB_CONFIG_JOURNAL_SLOT_SIZE);
+	k_mutex_unlock(&config_data.cache_lock);
+
+	config_flush_schedule(BCB_CONFIG_FLUSH_DELAY);
+
+	return 0;
+}
+
+#ifdef BCB_CONFIG_EEPROM_ASYNC
+static void on_page_written(struct device *dev, int result, void *user_data)
+{
+	struct config_page_write *write = user_data;
+
+	write->result = result;
+	k_sem_give(&config_data.page_writes_done);
+}
+
+/*
+ * Must be called with the flush lock held. All dirty pages are copied at once and queued in
+ * order, so that a main record is still written before its copy.
+ */
+static int config_flush_pages(void)
+{
+	struct config_page_write *write;
+	size_t count = 0;
+	size_t page;
+	size_t i;
+	int ret = 0;
+	int r;
+
+	/* Copied so that setters are not blocked by the EEPROM write cycles. */
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	for (page = 0; page < BCB_CONFIG_CACHE_PAGES; page++) {
+		if (!(config_data.cache_dirty & BIT(page))) {
+			continue;
+		}
+
+		write = &config_data.page_writes[count++];
+		write->req.offset = page * BCB_CONFIG_PAGE_SIZE;
+		write->req.buf = &config_data.flush_pages[write->req.offset];
+		write->req.len =
+			MIN(BCB_CONFIG_PAGE_SIZE, BCB_CONFIG_CACHE_SIZE - write->req.offset);
+		write->req.callback = on_page_written;
+		write->req.user_data = write;
+		memcpy(&config_data.flush_pages[write->req.offset],
+		       &config_data.cache[write->req.offset], write->req.len);
+	}
+	config_data.cache_dirty = 0;
+	k_mutex_unlock(&config_data.cache_lock);
+
+	for (i = 0; i < count; i++) {
+		write = &config_data.page_writes[i];
+		r = eeprom_m95080_write_async(config_data.dev_eeprom, &write->req);
+		if (r) {
+			on_page_written(config_data.dev_eeprom, r, write);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		k_sem_take(&config_data.page_writes_done, K_FOREVER);
+	}
+
+	for (i = 0; i < count; i++) {
+		write = &config_data.page_writes[i];
+		if (write->result) {
+			LOG_ERR("Cannot write EEPROM: %d", write->result);
+			k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+			config_data.cache_dirty |= BIT(write->req.offset / BCB_CONFIG_PAGE_SIZE);
+			k_mutex_unlock(&config_data.cache_lock);
+			ret = write->result;
+		}
+	}
+
+	return ret;
+}
+#else
+/* Must be called with the flush lock held. */
+static int config_flush_pages(void)
+{
+	size_t page;
+	uint8_t size;
+	int ret = 0;
+	int r;
+
+	for (page = 0; page < BCB_CONFIG_CACHE_PAGES; page++) {
+		size = MIN(BCB_CONFIG_PAGE_SIZE, BCB_CONFIG_CACHE_SIZE - page * BCB_CONFIG_PAGE_SIZE);
+
+		/* Copied so that setters are not blocked by the EEPROM write cycle. */
+		k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+		if (!(config_data.cache_dirty & BIT(page))) {
+			k_mutex_unlock(&config_data.cache_lock);
+			continue;
+		}
+		config_data.cache_dirty &= ~BIT(page);
+		memcpy(config_data.flush_buffer, &config_data.cache[page * BCB_CONFIG_PAGE_SIZE],
+		       size);
+		k_mutex_unlock(&config_data.cache_lock);
+
+		r = eeprom_write(config_data.dev_eeprom, page * BCB_CONFIG_PAGE_SIZE,
+				 config_data.flush_buffer, size);
+		if (r) {
+			LOG_ERR("Cannot write EEPROM: %d", r);
+			k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+			config_data.cache_dirty |= BIT(page);
+			k_mutex_unlock(&config_data.cache_lock);
+			ret = r;
+		}
+	}
+
+	return ret;
+}
+#endif
+
+static int config_flush(void)
+{
+	uint8_t version;
+	uint8_t size;
+	uint8_t id;
+	int ret;
+	int r;
+
+	k_mutex_lock(&config_data.flush_lock, K_FOREVER);
+
+	/* Updates from now on are not certain to be written by this flush. */
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	config_data.flush_deadline = 0;
+	k_mutex_unlock(&config_data.cache_lock);
+
+	ret = config_flush_pages();
+
+	for (id = 0; id < BCB_CONFIG_LOG_ID_END; id++) {
+		k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+		if (!config_data.log_cache[id].is_dirty) {
+			k_mutex_unlock(&config_data.cache_lock);
+			continue;
+		}
+		version = config_data.log_cache[id].version;
+		size = config_data.log_cache[id].size;
+		memcpy(config_data.flush_buffer, config_data.log_cache[id].data, size);
+		config_data.log_cache[id].is_dirty = false;
+		k_mutex_unlock(&config_data.cache_lock);
+
+		r = log_append(id, version, config_data.flush_buffer, size);
+		if (r) {
+			LOG_ERR("Cannot write record %d: %d", id, r);
+			k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+			if (!config_data.log_cache[id].is_dirty) {
+				config_data.log_cache[id].is_dirty = true;
+			}
+			k_mutex_unlock(&config_data.cache_lock);
+			ret = r;
+		}
+	}
+
+	k_mutex_unlock(&config_data.flush_lock);
+
+	/* What could not be written stays dirty and is retried. */
+	if (ret) {
+		config_flush_schedule(BCB_CONFIG_FLUSH_MAX_DELAY);
+	}
+
+	return ret;
+}
+
+static void on_flush_work(struct k_work *work)
+{
+	config_flush();
+}
+
+int bcb_config_sync(void)
+{
+	if (!config_data.dev_eeprom) {
+		LOG_ERR("Could not get EEPROM device");
+		return -ENOENT;
+	}
+
+	k_delayed_work_cancel(&config_data.flush_work);
+
+	return config_flush();
+}
+
+/* Must be called with the flush lock held. Returns true if a repair has to be flushed. */
+static bool scrub_records(void)
+{
+	const uint8_t *stored;
+	uint16_t stored_size;
+	uint8_t stored_version;
+	bool is_repairing = false;
+	uint8_t id;
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+
+	for (id = 0; id < BCB_CONFIG_ID_END; id++) {
+		if (!config_regions[id].size) {
+			continue;
+		}
+
+		if (config_regions[id].offset_b) {
+			is_repairing |= config_copies_sync(id) > 0;
+		} else if (config_record_check(id, config_regions[id].offset, &stored, &stored_size,
+					       &stored_version) == -EINVAL) {
+			LOG_ERR("Invalid record %d", id);
+			config_data.scrub_stats.errors++;
+			config_data.scrub_stats.failures++;
+		}
+	}
+
+	k_mutex_unlock(&config_data.cache_lock);
+
+	return is_repairing;
+}
+
+/* Must be called with the flush lock held, so that the pages which are not dirty hold what has
+ * been written. */
+static int scrub_pages(bool *is_repairing)
+{
+	size_t page;
+	uint8_t size;
+	int r;
+
+	for (page = 0; page < BCB_CONFIG_CACHE_PAGES; page++) {
+		size = MIN(BCB_CONFIG_PAGE_SIZE, BCB_CONFIG_CACHE_SIZE - page * BCB_CONFIG_PAGE_SIZE);
+
+		r = config_read_uncached(page * BCB_CONFIG_PAGE_SIZE, config_data.flush_buffer,
+					 size);
+		if (r) {
+			LOG_ERR("Cannot read EEPROM: %d", r);
+			return r;
+		}
+
+		k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+		if (!(config_data.cache_dirty & BIT(page)) &&
+		    memcmp(config_data.flush_buffer, &config_data.cache[page * BCB_CONFIG_PAGE_SIZE],
+			   size)) {
+			LOG_WRN("Rewriting corrupted page %zu", page);
+			config_data.cache_dirty |= BIT(page);
+			config_data.scrub_stats.errors++;
+			config_data.scrub_stats.repairs++;
+			*is_repairing = true;
+		}
+		k_mutex_unlock(&config_data.cache_lock);
+	}
+
 	return 0;
 }
 
+/* Must be called with the flush lock held. */
+static void scrub_log(bool *is_repairing)
+{
+	uint8_t id;
+
+	for (id = 0; id < BCB_CONFIG_LOG_ID_END; id++) {
+		if (!config_data.log_index[id].is_valid || !log_read(id, config_data.log_buffer)) {
+			continue;
+		}
+
+		LOG_WRN("Rewriting corrupted log record %d", id);
+
+		/* Appended again from the cache. */
+		k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+		config_data.scrub_stats.errors++;
+		if (config_data.log_cache[id].is_valid) {
+			config_data.log_cache[id].is_dirty = true;
+			config_data.scrub_stats.repairs++;
+			*is_repairing = true;
+		} else {
+			config_data.scrub_stats.failures++;
+		}
+		k_mutex_unlock(&config_data.cache_lock);
+	}
+}
+
+static int config_scrub(void)
+{
+	bool is_repairing;
+	int ret;
+	int r;
+
+	k_mutex_lock(&config_data.flush_lock, K_FOREVER);
+
+	is_repairing = scrub_records();
+	ret = scrub_pages(&is_repairing);
+	scrub_log(&is_repairing);
+
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	config_data.scrub_stats.runs++;
+	k_mutex_unlock(&config_data.cache_lock);
+
+	k_mutex_unlock(&config_data.flush_lock);
+
+	if (is_repairing) {
+		r = config_flush();
+		if (r) {
+			ret = r;
+		}
+	}
+
+	return ret;
+}
+
+static void on_scrub_work(struct k_work *work)
+{
+	config_scrub();
+
+	k_delayed_work_submit_to_queue(&config_data.flush_work_q, &config_data.scrub_work,
+				       K_SECONDS(BCB_CONFIG_SCRUB_INTERVAL));
+}
+
+int bcb_config_scrub(void)
+{
+	if (!config_data.dev_eeprom) {
+		LOG_ERR("Could not get EEPROM device");
+		return -ENOENT;
+	}
+
+	/* Without a valid cache, the EEPROM would be overwritten with it. */
+	if (!config_data.is_loaded) {
+		return -EIO;
+	}
+
+	return config_scrub();
+}
+
+void bcb_config_get_scrub_stats(bcb_config_scrub_stats_t *stats)
+{
+	k_mutex_lock(&config_data.cache_lock, K_FOREVER);
+	memcpy(stats, &config_data.scrub_stats, sizeof(bcb_config_scrub_stats_t));
+	k_mutex_unlock(&config_data.cache_lock);
+}
+
+static void log_restore(const uint8_t *buf)
+{
+	struct config_log_header header;
+	struct config_log_entry *entry;
+	struct config_log_cache *cache;
+	uint16_t last_end = 0;
+	uint16_t offset;
+	uint16_t crc;
+	uint8_t id;
+	bool is_found = false;
+
+	offset = 0;
+	while (offset + sizeof(header) <= BCB_CONFIG_LOG_SIZE) {
+		memcpy(&header, &buf[offset], sizeof(header));
+
+		if (header.magic != BCB_CONFIG_LOG_MAGIC || header.id >= BCB_CONFIG_LOG_ID_END ||
+		    offset + sizeof(header) + header.size > log_bank_end(log_bank_of(offset))) {
+			offset++;
+			continue;
+		}
+
+		crc = crc16_ccitt(0, (uint8_t *)&header, BCB_CONFIG_LOG_HEADER_CRC_SIZE);
+		crc = crc16_ccitt(crc, &buf[offset + sizeof(header)], header.size);
+		if (header.crc != crc) {
+			offset++;
+			continue;
+		}
+
+		entry = &config_data.log_index[header.id];
+		if (!entry->is_valid || header.seq > entry->seq) {
+			entry->offset = offset;
+			entry->seq = header.seq;
+			entry->version = header.version;
+			entry->size = header.size;
+			entry->is_valid = true;
+
+			cache = &config_data.log_cache[header.id];
+			memcpy(cache->data, &buf[offset + sizeof(header)], header.size);
+			cache->version = header.version;
+			cache->size = header.size;
+			cache->is_valid = true;
+		}
+
+		if (!is_found || header.seq > config_data.log_seq) {
+			/* Records are appended, so the newest one marks the write position. */
+			config_data.log_seq = header.seq;
+			config_data.log_bank = log_bank_of(offset);
+			last_end = offset + sizeof(header) + header.size;
+			is_found = true;
+		}
+
+		offset += sizeof(header) + header.size;
+	}
+
+	config_data.log_head = last_end;
+
+	/* Finish a compaction interrupted by a power loss; the next one overwrites the other bank. */
+	for (id = 0; id < BCB_CONFIG_LOG_ID_END; id++) {
+		entry = &config_data.log_index[id];
+		if (entry->is_valid && log_bank_of(entry->offset) != config_data.log_bank &&
+		    config_data.log_head + sizeof(header) + entry->size <=
+			    log_bank_end(config_data.log_bank)) {
+			log_relocate(id);
+		}
+	}
+
+	LOG_DBG("log bank %d, head %" PRIu16 ", seq %" PRIu32, config_data.log_bank,
+		config_data.log_head, config_data.log_seq);
+}
+
 int bcb_config_init(void)
 {
+	uint8_t *buf;
+	int r;
+
 	config_data.dev_eeprom = device_get_binding(BCB_CONFIG_EEPROM_LABEL);
 	if (!config_data.dev_eeprom) {
 		LOG_ERR("Could not get EEPROM device");
 		return -ENOENT;
 	}
 
-	return 0;
+	k_mutex_init(&config_data.cache_lock);
+	k_mutex_init(&config_data.flush_lock);
+#ifdef BCB_CONFIG_EEPROM_ASYNC
+	k_sem_init(&config_data.page_writes_done, 0, BCB_CONFIG_CACHE_PAGES);
+#endif
+	k_delayed_work_init(&config_data.flush_work, on_flush_work);
+	k_delayed_work_init(&config_data.scrub_work, on_scrub_work);
+	k_work_q_start(&config_data.flush_work_q, config_flush_stack,
+		       K_THREAD_STACK_SIZEOF(config_flush_stack),
+		       CONFIG_BCB_LIB_PERSISTENT_CONFIG_FLUSH_PRIORITY);
+
+	/* The whole partition is read in a single transfer and parsed from RAM. */
+	buf = k_malloc(BCB_CONFIG_PARTITION_SIZE);
+	if (!buf) {
+		return -ENOMEM;
+	}
+
+	r = eeprom_read(config_data.dev_eeprom, 0, buf, BCB_CONFIG_PARTITION_SIZE);
+	if (r) {
+		LOG_ERR("Cannot read EEPROM: %d", r);
+	} else {
+		memcpy(config_data.cache, buf, BCB_CONFIG_CACHE_SIZE);
+		log_restore(&buf[BCB_CONFIG_LOG_OFFSET]);
+	}
+
+	k_free(buf);
+
+	config_data.is_loaded = !r;
+
+	if (config_data.is_loaded && BCB_CONFIG_SCRUB_INTERVAL) {
+		k_delayed_work_submit_to_queue(&config_data.flush_work_q, &config_data.scrub_work,
+					       K_SECONDS(BCB_CONFIG_SCRUB_INTERVAL));
+	}
+
+	return r;
 }
\ No newline at end of file
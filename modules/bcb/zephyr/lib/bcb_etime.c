@@ -1,4 +1,5 @@
 #include <lib/bcb_etime.h>
+#include <lib/bcb_tbase.h>
 #include <device.h>
 #include <devicetree.h>
 #include <drivers/counter_ctd.h>
@@ -8,9 +9,17 @@
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bcb_etime);
 
+// clang-format off
+#define ETIME_CH_LOW            1
+#define ETIME_CH_HIGH           2
+// clang-format on
+
 struct bcb_etime_data {
     struct device *dev_cnt_ctd;
     uint32_t ticks_per_sec;
+    bcb_tbase_t to_ns;
+    bcb_tbase_t from_ns;
+    bcb_tbase_t from_us;
 };
 
 static struct bcb_etime_data bcb_etime_data;
@@ -30,6 +39,11 @@ int bcb_etime_init(void)
 
     LOG_DBG("ticks_per_sec %" PRIu32, bcb_etime_data.ticks_per_sec);
 
+    /* The only divisions; conversions afterwards are multiply and shift. */
+    bcb_tbase_init(&bcb_etime_data.to_ns, bcb_etime_data.ticks_per_sec, 1000000000);
+    bcb_tbase_init(&bcb_etime_data.from_ns, 1000000000, bcb_etime_data.ticks_per_sec);
+    bcb_tbase_init(&bcb_etime_data.from_us, 1000000, bcb_etime_data.ticks_per_sec);
+
     /* We use channel 0 is used as a prescaller */
     counter_ctd_set_top_value(bcb_etime_data.dev_cnt_ctd, 0, prescale - 1);
     counter_ctd_set_top_value(bcb_etime_data.dev_cnt_ctd, 1, UINT32_MAX);
@@ -47,13 +61,39 @@ int bcb_etime_init(void)
 
 uint64_t bcb_etime_get_now()
 {
-    uint32_t ctd_l = UINT32_MAX - counter_ctd_get_value(bcb_etime_data.dev_cnt_ctd, 1); 
-    uint32_t ctd_h = UINT32_MAX - counter_ctd_get_value(bcb_etime_data.dev_cnt_ctd, 2);
+    uint32_t ctd_h;
+    uint32_t ctd_l;
+    uint32_t ctd_h_prev;
+
+    /* The low word may wrap between the two reads. The high word is read again to detect that
+     * and the low word is re-read to pair it with the new high word. Both channels count down,
+     * hence the inversion. No locking is needed, so this is safe to call from any context. */
+    ctd_h = counter_ctd_get_value(bcb_etime_data.dev_cnt_ctd, ETIME_CH_HIGH);
+    do {
+        ctd_h_prev = ctd_h;
+        ctd_l = counter_ctd_get_value(bcb_etime_data.dev_cnt_ctd, ETIME_CH_LOW);
+        ctd_h = counter_ctd_get_value(bcb_etime_data.dev_cnt_ctd, ETIME_CH_HIGH);
+    } while (ctd_h != ctd_h_prev);
 
-    return (uint64_t)ctd_l + ((uint64_t)ctd_h << 32);;
+    return (uint64_t)(UINT32_MAX - ctd_l) + ((uint64_t)(UINT32_MAX - ctd_h) << 32);
 }
 
 uint32_t bcb_etime_get_frequency()
 {
     return bcb_etime_data.ticks_per_sec;
 }
+
+uint64_t bcb_etime_to_ns(uint64_t ticks)
+{
+    return bcb_tbase_convert(&bcb_etime_data.to_ns, ticks);
+}
+
+uint64_t bcb_etime_from_ns(uint64_t ns)
+{
+    return bcb_tbase_convert(&bcb_etime_data.from_ns, ns);
+}
+
+uint64_t bcb_etime_from_us(uint64_t us)
+{
+    return bcb_tbase_convert(&bcb_etime_data.from_us, us);
+}
@@ -0,0 +1,266 @@
+#include <lib/bcb_journal.h>
+#include <lib/bcb_config.h>
+#include <lib/bcb_msmnt.h>
+#include <lib/bcb_tc.h>
+#include <kernel.h>
+#include <sys/crc.h>
+#include <soc.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_LEVEL CONFIG_BCB_LIB_JOURNAL_LOG_LEVEL
+#include <logging/log.h>
+LOG_MODULE_REGISTER(bcb_journal);
+
+// clang-format off
+#define TRIP_SIZE               CONFIG_BCB_LIB_JOURNAL_SIZE
+#define OTHER_SIZE              CONFIG_BCB_LIB_JOURNAL_OTHER_SIZE
+#define SLOTS                   (TRIP_SIZE + OTHER_SIZE)
+#define ENTRY_CRC_SIZE          offsetof(struct journal_entry, crc)
+// clang-format on
+
+/* Trips and recoveries are kept apart, so that frequent events cannot evict them. */
+enum journal_ring {
+	RING_TRIP = 0,
+	RING_OTHER,
+	RING_END,
+};
+
+/* Stored in its own slot. A slot without a valid CRC or with sequence number 0 is empty. */
+struct __attribute__((packed)) journal_entry {
+	uint32_t seq;
+	uint32_t uptime;
+	uint8_t type;
+	uint8_t arg;
+	int32_t value;
+	uint16_t crc;
+};
+
+struct bcb_journal_data {
+	/* Protected by locking the interrupts */
+	struct journal_entry entries[SLOTS];
+	uint8_t next[RING_END]; /* Index in the ring of the slot to be written next */
+	uint32_t seq; /* Sequence number of the latest event */
+	uint32_t dirty; /* Slots to be stored */
+	struct k_work store_work;
+	bool is_initialized;
+};
+
+static struct bcb_journal_data journal_data;
+
+BUILD_ASSERT(sizeof(struct journal_entry) == BCB_CONFIG_JOURNAL_SLOT_SIZE,
+	     "Journal entries must fill a slot");
+BUILD_ASSERT(SLOTS <= BCB_CONFIG_JOURNAL_SLOTS, "Journal area is too small");
+BUILD_ASSERT(SLOTS <= 32, "Dirty slot mask is too small");
+
+static const uint8_t ring_first[RING_END] = {
+	[RING_TRIP] = 0,
+	[RING_OTHER] = TRIP_SIZE,
+};
+
+static const uint8_t ring_size[RING_END] = {
+	[RING_TRIP] = TRIP_SIZE,
+	[RING_OTHER] = OTHER_SIZE,
+};
+
+static const char *const type_names[BCB_JOURNAL_TYPE_END] = {
+	[BCB_JOURNAL_TYPE_BOOT] = "boot",
+	[BCB_JOURNAL_TYPE_TRIP] = "trip",
+	[BCB_JOURNAL_TYPE_RECOVERY] = "recovery",
+	[BCB_JOURNAL_TYPE_OCP_TEST] = "ocp test",
+	[BCB_JOURNAL_TYPE_CONFIG] = "config",
+};
+
+static inline enum journal_ring ring_of(bcb_journal_type_t type)
+{
+	return (type == BCB_JOURNAL_TYPE_TRIP || type == BCB_JOURNAL_TYPE_RECOVERY) ? RING_TRIP :
+										      RING_OTHER;
+}
+
+static void on_store_work(struct k_work *work)
+{
+	struct journal_entry entries[SLOTS];
+	uint32_t dirty;
+	unsigned int key;
+	uint8_t slot;
+	int r;
+
+	key = irq_lock();
+	dirty = journal_data.dirty;
+	journal_data.dirty = 0;
+	memcpy(entries, journal_data.entries, sizeof(entries));
+	irq_unlock(key);
+
+	for (slot = 0; slot < SLOTS; slot++) {
+		if (!(dirty & BIT(slot))) {
+			continue;
+		}
+
+		entries[slot].crc = crc16_ccitt(0, (uint8_t *)&entries[slot], ENTRY_CRC_SIZE);
+
+		r = bcb_config_journal_store(slot, (uint8_t *)&entries[slot]);
+		if (r) {
+			LOG_ERR("cannot store journal slot %" PRIu8 ": %d", slot, r);
+		}
+	}
+}
+
+static bool entry_is_valid(const struct journal_entry *entry)
+{
+	return entry->seq && entry->type < BCB_JOURNAL_TYPE_END &&
+	       entry->crc == crc16_ccitt(0, (const uint8_t *)entry, ENTRY_CRC_SIZE);
+}
+
+static void restore_entries(void)
+{
+	struct journal_entry *entry;
+	uint32_t latest;
+	uint8_t ring;
+	uint8_t i;
+	int r;
+
+	for (ring = 0; ring < RING_END; ring++) {
+		latest = 0;
+
+		for (i = 0; i < ring_size[ring]; i++) {
+			entry = &journal_data.entries[ring_first[ring] + i];
+
+			r = bcb_config_journal_load(ring_first[ring] + i, (uint8_t *)entry);
+			if (r || !entry_is_valid(entry) || ring_of(entry->type) != ring) {
+				memset(entry, 0, sizeof(struct journal_entry));
+				continue;
+			}
+
+			if (entry->seq > latest) {
+				latest = entry->seq;
+				journal_data.next[ring] = (i + 1) % ring_size[ring];
+			}
+		}
+
+		journal_data.seq = MAX(journal_data.seq, latest);
+	}
+}
+
+int bcb_journal_init(void)
+{
+	k_work_init(&journal_data.store_work, on_store_work);
+	restore_entries();
+	journal_data.is_initialized = true;
+
+	/* Reset sources tell a power loss from other resets. */
+	bcb_journal_add(BCB_JOURNAL_TYPE_BOOT, RCM->SRS0, RCM->SRS1);
+
+	LOG_INF("latest event %" PRIu32, journal_data.seq);
+
+	return 0;
+}
+
+void bcb_journal_add(bcb_journal_type_t type, uint8_t arg, int32_t value)
+{
+	enum journal_ring ring = ring_of(type);
+	struct journal_entry *entry;
+	unsigned int key;
+	uint8_t slot;
+
+	if (!journal_data.is_initialized) {
+		return;
+	}
+
+	key = irq_lock();
+
+	slot = ring_first[ring] + journal_data.next[ring];
+	journal_data.next[ring] = (journal_data.next[ring] + 1) % ring_size[ring];
+
+	entry = &journal_data.entries[slot];
+	entry->seq = ++journal_data.seq;
+	entry->uptime = k_uptime_get_32();
+	entry->type = type;
+	entry->arg = arg;
+	entry->value = value;
+	journal_data.dirty |= BIT(slot);
+
+	irq_unlock(key);
+
+	k_work_submit(&journal_data.store_work);
+}
+
+void bcb_journal_add_trip(bcb_journal_type_t type, uint8_t cause)
+{
+	int32_t value;
+
+	if (cause == BCB_TC_CAUSE_OTP) {
+		value = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_IN);
+	} else {
+		value = (int32_t)MIN(bcb_msmnt_get_current_rms(), INT32_MAX);
+	}
+
+	bcb_journal_add(type, cause, value);
+}
+
+int bcb_journal_get_range(uint32_t *first, uint32_t *last)
+{
+	uint32_t oldest = UINT32_MAX;
+	unsigned int key;
+	uint8_t slot;
+	int r = 0;
+
+	key = irq_lock();
+
+	for (slot = 0; slot < SLOTS; slot++) {
+		if (journal_data.entries[slot].seq) {
+			oldest = MIN(oldest, journal_data.entries[slot].seq);
+		}
+	}
+
+	if (!journal_data.seq) {
+		r = -ENOENT;
+	} else {
+		*first = oldest;
+		*last = journal_data.seq;
+	}
+
+	irq_unlock(key);
+
+	return r;
+}
+
+int bcb_journal_get_next(uint32_t after, bcb_journal_event_t *event)
+{
+	struct journal_entry *entry = NULL;
+	unsigned int key;
+	uint8_t slot;
+
+	key = irq_lock();
+
+	for (slot = 0; slot < SLOTS; slot++) {
+		if (journal_data.entries[slot].seq > after &&
+		    (!entry || journal_data.entries[slot].seq < entry->seq)) {
+			entry = &journal_data.entries[slot];
+		}
+	}
+
+	if (!entry) {
+		irq_unlock(key);
+		return -ENOENT;
+	}
+
+	event->seq = entry->seq;
+	event->uptime = entry->uptime;
+	event->type = (bcb_journal_type_t)entry->type;
+	event->arg = entry->arg;
+	event->value = entry->value;
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+const char *bcb_journal_get_type_name(bcb_journal_type_t type)
+{
+	if (type >= BCB_JOURNAL_TYPE_END) {
+		return "unknown";
+	}
+
+	return type_names[type];
+}
@@ -1,6 +1,11 @@
 #include <lib/bcb_msmnt.h>
 #include <lib/bcb_config.h>
+#include <lib/bcb_etime.h>
 #include <drivers/adc_dma.h>
+#include <drivers/adc_trigger.h>
+#ifdef CONFIG_ADC_MCUX_ADC16
+#include <adc_mcux_edma.h>
+#endif
 #include <device.h>
 #include <devicetree.h>
 #include <arm_math.h>
@@ -12,6 +17,9 @@ LOG_MODULE_REGISTER(bcb_msmnt);
 
 #define BCB_MSMNT_RMS_SAMPLES ((1U) << CONFIG_BCB_LIB_MSMNT_RMS_SAMPLES)
 #define BCB_MSMNT_RMS_SAMPLES_SHIFT (CONFIG_BCB_LIB_MSMNT_RMS_SAMPLES)
+#define BCB_MSMNT_FAST_FRAMES (CONFIG_BCB_LIB_MSMNT_FAST_FRAMES)
+#define BCB_MSMNT_FAST_CHANNELS 3 /* i_low_gain, i_high_gain and v_mains on ADC0 */
+#define BCB_MSMNT_CONFIG_VERSION 1
 
 #define BCB_MSMNT_ADC_SEQ_ADD(ds, dt_node, ch_name)                                                \
 	do {                                                                                       \
@@ -41,6 +49,12 @@ typedef struct __attribute__((packed)) bcb_msmnt_config_data {
 	uint16_t v_mains_cal_b;
 } bcb_msmnt_config_data_t;
 
+#ifdef CONFIG_ADC_MCUX_ADC16
+/* The calibration fills the default region exactly; a new field needs a larger region. */
+BCB_CONFIG_ASSERT_SIZE(MSMNT, sizeof(bcb_msmnt_config_data_t) +
+				      2 * sizeof(adc_mcux_calibration_values_t));
+#endif
+
 struct bcb_msmnt_data {
 	/* ADC0 */
 	struct device *dev_adc_0;
@@ -52,6 +66,10 @@ struct bcb_msmnt_data {
 	uint8_t seq_len_adc_1;
 	volatile uint16_t *buffer_adc_1;
 	size_t buffer_size_adc_1;
+	volatile uint16_t *frame_adc_0;
+	uint32_t frame_interval_adc_0;
+	sys_slist_t frames_callback_list;
+	sys_slist_t window_list;
 	/* ADC0 channel values */
 	volatile uint16_t *raw_i_low_gain;
 	volatile uint16_t *raw_i_high_gain;
@@ -86,7 +104,12 @@ typedef struct bcb_msmnt_ntc_tbl {
 
 static struct bcb_msmnt_data bcb_msmnt_data;
 
-static uint16_t buffer_adc_0[DT_PROP(DT_NODELABEL(adc0), max_channels)] __attribute__((aligned(2)));
+static uint16_t buffer_adc_0[DT_PROP(DT_NODELABEL(adc0), max_channels) * BCB_MSMNT_FAST_FRAMES]
+	__attribute__((aligned(2)));
+BUILD_ASSERT(BCB_MSMNT_FAST_FRAMES % 2 == 0, "Fast frames must be split into two halves");
+BUILD_ASSERT(BCB_MSMNT_FAST_FRAMES * BCB_MSMNT_FAST_CHANNELS > ADC_DMA_HALF_CALLBACK_MIN_SAMPLES,
+	     "Too few fast frames for the half buffer callback");
+
 static uint16_t buffer_adc_1[DT_PROP(DT_NODELABEL(adc1), max_channels)] __attribute__((aligned(2)));
 
 static bcb_msmnt_ntc_tbl_t bcb_msmnt_ntc_tbl_data[] = {
@@ -102,6 +125,53 @@ static bcb_msmnt_ntc_tbl_t bcb_msmnt_ntc_tbl_data[] = {
 
 static void bcb_msmnt_on_rms_timer(struct k_timer *timer);
 
+static void bcb_msmnt_on_adc_0_frames(struct device *dev, volatile void *buffer, uint32_t samples)
+{
+	uint64_t etime = bcb_etime_get_now();
+	uint8_t seq_len = bcb_msmnt_data.seq_len_adc_0;
+	volatile uint16_t *frame = (volatile uint16_t *)buffer + (samples - seq_len);
+	volatile uint16_t *frame_old = bcb_msmnt_data.frame_adc_0;
+	struct bcb_msmnt_frames_callback *callback;
+	bcb_msmnt_frames_t frames;
+
+	/* Keep the channel values pointing to the latest completed frame since the buffer
+	 * holds multiple frames.
+	 */
+	bcb_msmnt_data.raw_i_low_gain = frame + (bcb_msmnt_data.raw_i_low_gain - frame_old);
+	bcb_msmnt_data.raw_i_high_gain = frame + (bcb_msmnt_data.raw_i_high_gain - frame_old);
+	bcb_msmnt_data.raw_v_mains = frame + (bcb_msmnt_data.raw_v_mains - frame_old);
+	bcb_msmnt_data.frame_adc_0 = frame;
+
+	if (sys_slist_is_empty(&bcb_msmnt_data.frames_callback_list)) {
+		return;
+	}
+
+	frames.buffer = (volatile uint16_t *)buffer;
+	frames.count = samples / seq_len;
+	frames.stride = seq_len;
+	frames.interval = bcb_msmnt_data.frame_interval_adc_0;
+	frames.etime = etime;
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&bcb_msmnt_data.frames_callback_list, callback, node) {
+		if (callback->handler) {
+			callback->handler(&frames);
+		}
+	}
+}
+
+static void bcb_msmnt_on_adc_1_frames(struct device *dev, volatile void *buffer, uint32_t samples)
+{
+	struct bcb_msmnt_window *window;
+	uint16_t raw;
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&bcb_msmnt_data.window_list, window, node) {
+		raw = bcb_msmnt_get_raw(window->type);
+		if ((raw < window->low || raw > window->high) && window->handler) {
+			window->handler(window, raw);
+		}
+	}
+}
+
 static int32_t get_temp_adc(uint32_t adc_ntc)
 {
 	/* ADC is referenced to 3V (3000 millivolt). */
@@ -152,6 +222,53 @@ static int32_t get_temp_mcu(uint32_t adc_ntc)
 	return (int32_t)(25.0f - (((float)v_ntc - 716.0f) / 1.62f));
 }
 
+/* Lowest ADC reading that gives a non-zero NTC resistance (1 mV). */
+#define NTC_RAW_MIN (((1U << 16) + 2999U) / 3000U)
+
+/**
+ * @brief   Converts a temperature into a raw ADC reading of a sensor
+ *
+ * All temperature sensors have a negative temperature coefficient. So any raw reading
+ * lower than the returned value corresponds to a temperature higher than the given one.
+ * Uses a binary search over the (floating-point) conversion, hence should not be called
+ * from time critical code.
+ *
+ * @param sensor    Type of the sensor.
+ * @param temp      Temperature in centigrade.
+ * @return uint16_t Lowest raw reading for which the temperature is not higher than temp.
+ */
+uint16_t bcb_msmnt_temp_to_raw(bcb_temp_sensor_t sensor, int32_t temp)
+{
+	int32_t (*get_temp)(uint32_t adc_ntc);
+	uint32_t lo;
+	uint32_t hi;
+	uint32_t mid;
+
+	if (sensor == BCB_TEMP_SENSOR_MCU) {
+		get_temp = get_temp_mcu;
+		lo = 0;
+	} else {
+		get_temp = get_temp_adc;
+		lo = NTC_RAW_MIN;
+	}
+
+	hi = UINT16_MAX;
+	if (get_temp(hi) > temp) {
+		return UINT16_MAX;
+	}
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (get_temp(mid) > temp) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return (uint16_t)lo;
+}
+
 /**
  * @brief   Returns the temperature read from a sensor
  * 
@@ -429,6 +546,8 @@ int bcb_msmnt_init(void)
 	int r;
 
 	memset(&bcb_msmnt_data, 0, sizeof(bcb_msmnt_data));
+	sys_slist_init(&bcb_msmnt_data.frames_callback_list);
+	sys_slist_init(&bcb_msmnt_data.window_list);
 	k_timer_init(&bcb_msmnt_data.timer_rms, bcb_msmnt_on_rms_timer, NULL);
 
 	bcb_msmnt_data.buffer_adc_0 = buffer_adc_0;
@@ -467,6 +586,7 @@ int bcb_msmnt_init(void)
 int bcb_msmnt_start(void)
 {
 	adc_dma_sequence_config_t adc_seq_cfg;
+	struct device *trigger_dev;
 
 	bcb_msmnt_data.seq_len_adc_0 = 0;
 	bcb_msmnt_data.seq_len_adc_1 = 0;
@@ -487,18 +607,30 @@ int bcb_msmnt_start(void)
 	BCB_MSMNT_ADC_SEQ_ADD(&bcb_msmnt_data, aread, oc_test_adj);
 	BCB_MSMNT_ADC_SEQ_ADD(&bcb_msmnt_data, aread, ref_1v5);
 
+	bcb_msmnt_data.frame_adc_0 = bcb_msmnt_data.buffer_adc_0;
+
 	adc_seq_cfg.buffer = bcb_msmnt_data.buffer_adc_0;
 	adc_seq_cfg.buffer_size = bcb_msmnt_data.buffer_size_adc_0;
 	adc_seq_cfg.len = bcb_msmnt_data.seq_len_adc_0;
-	adc_seq_cfg.samples = adc_seq_cfg.len;
-	adc_seq_cfg.callback = NULL;
+	adc_seq_cfg.samples = adc_seq_cfg.len * BCB_MSMNT_FAST_FRAMES;
+	adc_seq_cfg.callback = bcb_msmnt_on_adc_0_frames;
 	adc_dma_read(bcb_msmnt_data.dev_adc_0, &adc_seq_cfg);
 
+	trigger_dev = device_get_binding(adc_dma_get_trig_dev(bcb_msmnt_data.dev_adc_0));
+	if (trigger_dev) {
+		/* Trigger interval is in nano seconds and one trigger converts one channel. */
+		bcb_msmnt_data.frame_interval_adc_0 = bcb_etime_from_ns(
+			(uint64_t)adc_trigger_get_interval(trigger_dev) *
+			bcb_msmnt_data.seq_len_adc_0);
+	} else {
+		LOG_ERR("Could not get ADC0 trigger device");
+	}
+
 	adc_seq_cfg.buffer = bcb_msmnt_data.buffer_adc_1;
 	adc_seq_cfg.buffer_size = bcb_msmnt_data.buffer_size_adc_1;
 	adc_seq_cfg.len = bcb_msmnt_data.seq_len_adc_1;
 	adc_seq_cfg.samples = adc_seq_cfg.len;
-	adc_seq_cfg.callback = NULL;
+	adc_seq_cfg.callback = bcb_msmnt_on_adc_1_frames;
 	adc_dma_read(bcb_msmnt_data.dev_adc_1, &adc_seq_cfg);
 
 	k_timer_start(&bcb_msmnt_data.timer_rms, K_MSEC(CONFIG_BCB_LIB_MSMNT_RMS_INTERVAL),
@@ -516,6 +648,89 @@ int bcb_msmnt_stop(void)
 	return 0;
 }
 
+int bcb_msmnt_get_frame_index(bcb_msmnt_type_t type)
+{
+	unsigned int key;
+	int index;
+
+	key = irq_lock();
+
+	switch (type) {
+	case BCB_MSMNT_TYPE_I_LOW_GAIN:
+		index = bcb_msmnt_data.raw_i_low_gain - bcb_msmnt_data.frame_adc_0;
+		break;
+	case BCB_MSMNT_TYPE_I_HIGH_GAIN:
+		index = bcb_msmnt_data.raw_i_high_gain - bcb_msmnt_data.frame_adc_0;
+		break;
+	case BCB_MSMNT_TYPE_V_MAINS:
+		index = bcb_msmnt_data.raw_v_mains - bcb_msmnt_data.frame_adc_0;
+		break;
+	default:
+		index = -ENOTSUP;
+		break;
+	}
+
+	irq_unlock(key);
+
+	return index;
+}
+
+int bcb_msmnt_add_frames_callback(struct bcb_msmnt_frames_callback *callback)
+{
+	unsigned int key;
+
+	if (!callback || !callback->handler) {
+		return -ENOTSUP;
+	}
+
+	key = irq_lock();
+	sys_slist_append(&bcb_msmnt_data.frames_callback_list, &callback->node);
+	irq_unlock(key);
+
+	return 0;
+}
+
+void bcb_msmnt_remove_frames_callback(struct bcb_msmnt_frames_callback *callback)
+{
+	unsigned int key;
+
+	if (!callback) {
+		return;
+	}
+
+	key = irq_lock();
+	sys_slist_find_and_remove(&bcb_msmnt_data.frames_callback_list, &callback->node);
+	irq_unlock(key);
+}
+
+int bcb_msmnt_add_window(struct bcb_msmnt_window *window)
+{
+	unsigned int key;
+
+	if (!window || !window->handler || window->type < BCB_MSMNT_TYPE_T_PWR_IN) {
+		return -ENOTSUP;
+	}
+
+	key = irq_lock();
+	sys_slist_append(&bcb_msmnt_data.window_list, &window->node);
+	irq_unlock(key);
+
+	return 0;
+}
+
+void bcb_msmnt_remove_window(struct bcb_msmnt_window *window)
+{
+	unsigned int key;
+
+	if (!window) {
+		return;
+	}
+
+	key = irq_lock();
+	sys_slist_find_and_remove(&bcb_msmnt_data.window_list, &window->node);
+	irq_unlock(key);
+}
+
 int bcb_msmnt_config_load(void)
 {
 	int r;
@@ -536,7 +751,13 @@ int bcb_msmnt_config_load(void)
 		return -ENOMEM;
 	}
 
-	r = bcb_config_load(CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_MSMNT, buf, size_total);
+	/* Current values are kept for the parts an older stored config does not have. */
+	memcpy(buf, &bcb_msmnt_data.config, size_config);
+	adc_dma_get_calibration_values(bcb_msmnt_data.dev_adc_0, buf + size_config, size_adc_0);
+	adc_dma_get_calibration_values(bcb_msmnt_data.dev_adc_1, buf + size_config + size_adc_0,
+				       size_adc_1);
+
+	r = bcb_config_load(BCB_CONFIG_ID_MSMNT, BCB_MSMNT_CONFIG_VERSION, buf, size_total, NULL);
 	if (r) {
 		LOG_ERR("configuration loading error: %d", r);
 		goto cleanup;
@@ -601,7 +822,12 @@ int bcb_msmnt_config_store(void)
 		goto cleanup;
 	}
 
-	r = bcb_config_store(CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_MSMNT, buf, size_total);
+	r = bcb_config_store(BCB_CONFIG_ID_MSMNT, BCB_MSMNT_CONFIG_VERSION, buf, size_total);
+	if (!r) {
+		/* Calibration must be on the EEPROM before it is reported as stored. */
+		r = bcb_config_sync();
+	}
+
 	if (r) {
 		LOG_ERR("configuration storing error: %d", r);
 	}
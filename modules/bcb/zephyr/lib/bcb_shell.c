@@ -1,10 +1,19 @@
 #include <lib/bcb.h>
+#include <lib/bcb_boot.h>
+#include <lib/bcb_config.h>
+#include <lib/bcb_journal.h>
 #include <lib/bcb_msmnt.h>
 #include <lib/bcb_msmnt_calib.h>
 #include <lib/bcb_sw.h>
+#include <lib/bcb_sw_stats.h>
 #include <lib/bcb_zd.h>
+#include <lib/bcb_etime.h>
 #include <lib/bcb_tc_def.h>
+#include <lib/bcb_tc_def_msm.h>
+#include <lib/bcb_tc_def_rec.h>
+#include <lib/bcb_tc_def_ocpt.h>
 #include <stdlib.h>
+#include <string.h>
 #include <zephyr.h>
 #include <device.h>
 #include <shell/shell.h>
@@ -110,6 +119,217 @@ static int cmd_frequency_handler(const struct shell *shell, size_t argc, char **
 
 	uint32_t frequency = bcb_zd_get_frequency();
 	shell_print(shell, "%" PRIu32 ".%03" PRIu32 " Hz", frequency / 1000, frequency % 1000);
+	shell_print(shell, "zero-crossing prediction error %" PRId32 " ns",
+		    bcb_zd_get_prediction_error());
+	shell_print(shell, "glitches %" PRIu32, bcb_zd_get_glitch_count());
+	shell_print(shell, "pll: %s, period %" PRIu32 " ns",
+		    bcb_zd_is_locked() ? "locked" : "unlocked",
+		    (uint32_t)bcb_etime_to_ns(bcb_zd_get_period()));
+
+	return 0;
+}
+
+static int cmd_recovery_handler(const struct shell *shell, size_t argc, char **argv)
+{
+	bcb_tc_def_msm_config_t config;
+	bcb_tc_def_rec_attempt_t attempt;
+	uint8_t i;
+	int r;
+
+	bcb_tc_def_msm_config_get(&config);
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "fixed")) {
+			config.rec_policy = BCB_TC_DEF_MSM_REC_POLICY_FIXED;
+		} else if (!strcmp(argv[1], "backoff")) {
+			config.rec_policy = BCB_TC_DEF_MSM_REC_POLICY_BACKOFF;
+		} else {
+			shell_error(shell, "invalid policy %s", argv[1]);
+			shell_print(shell, "%s - [fixed|backoff]", argv[0]);
+			return -EINVAL;
+		}
+
+		r = bcb_tc_def_msm_config_set(&config);
+		if (r) {
+			shell_error(shell, "cannot set policy %d", r);
+			return r;
+		}
+	}
+
+	shell_print(shell, "policy: %s",
+		    config.rec_policy == BCB_TC_DEF_MSM_REC_POLICY_BACKOFF ? "backoff" : "fixed");
+
+	for (i = 0; !bcb_tc_def_rec_get_attempt(i, &attempt); i++) {
+		if (attempt.trip_duration == UINT32_MAX) {
+			shell_print(shell, "%10" PRIu32 " ms: delay %" PRIu32 " us, no trip",
+				    attempt.timestamp, attempt.delay);
+		} else {
+			shell_print(shell, "%10" PRIu32 " ms: delay %" PRIu32 " us, trip %" PRIu32 " ns",
+				    attempt.timestamp, attempt.delay, attempt.trip_duration);
+		}
+		shell_print(shell, "%16s inrush %" PRIu32 " mA, tail %" PRIu32 " mA", "",
+			    attempt.inrush_peak, attempt.inrush_tail);
+	}
+
+	return 0;
+}
+
+static int cmd_selftest_handler(const struct shell *shell, size_t argc, char **argv)
+{
+	bcb_tc_def_ocpt_result_t result;
+	bcb_tc_def_ocpt_trend_t trend;
+	bcb_ocp_direction_t direction;
+	uint8_t i;
+	int r;
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "run")) {
+			r = bcb_tc_def_ocpt_run();
+		} else if (!strcmp(argv[1], "interval") && argc > 2) {
+			r = bcb_tc_def_ocpt_set_interval((uint16_t)strtoul(argv[2], NULL, 10));
+		} else {
+			shell_print(shell, "%s - [run|interval <hours>]", argv[0]);
+			return -EINVAL;
+		}
+
+		if (r) {
+			shell_error(shell, "failed %d", r);
+			return r;
+		}
+	}
+
+	shell_print(shell, "interval: %" PRIu16 " h", bcb_tc_def_ocpt_get_interval());
+
+	for (direction = BCB_OCP_DIRECTION_POSITIVE; direction <= BCB_OCP_DIRECTION_NEGATIVE;
+	     direction++) {
+		bcb_tc_def_ocpt_get_trend(direction, &trend);
+		shell_print(shell,
+			    "%c: count %" PRIu8 ", failures %" PRIu8 ", min %" PRIu32
+			    " ns, mean %" PRIu32 " ns, max %" PRIu32 " ns, drift %" PRId32 " ns",
+			    direction == BCB_OCP_DIRECTION_POSITIVE ? 'p' : 'n', trend.count,
+			    trend.failures, trend.min, trend.mean, trend.max, trend.drift);
+	}
+
+	for (i = 0; !bcb_tc_def_ocpt_get_result(i, &result); i++) {
+		shell_print(shell, "%5" PRIu16 " %c: %s, %" PRIu32 " ns", result.seq,
+			    result.direction == BCB_OCP_DIRECTION_POSITIVE ? 'p' : 'n',
+			    result.passed ? "pass" : "fail", result.duration);
+	}
+
+	return 0;
+}
+
+static int cmd_stats_handler(const struct shell *shell, size_t argc, char **argv)
+{
+	static const char *const names[BCB_SW_STATS_END] = {
+		[BCB_SW_STATS_ON_OFF_EXT] = "on-off ext",
+		[BCB_SW_STATS_ON_OFF_OCP] = "on-off ocp",
+		[BCB_SW_STATS_ON_OFF_OTP] = "on-off otp",
+		[BCB_SW_STATS_ON_OFF_UVP] = "on-off uvp",
+		[BCB_SW_STATS_OCP_TEST] = "ocp test",
+		[BCB_SW_STATS_CLOSE] = "close",
+	};
+	bcb_sw_stats_t stats;
+	uint8_t type;
+	uint8_t i;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "reset")) {
+			shell_print(shell, "%s - [reset]", argv[0]);
+			return -EINVAL;
+		}
+
+		bcb_sw_stats_reset();
+		return 0;
+	}
+
+	for (type = 0; type < BCB_SW_STATS_END; type++) {
+		bcb_sw_stats_get(type, &stats);
+		shell_print(shell,
+			    "%-10s: count %" PRIu32 ", min %" PRIu32 " ns, mean %" PRIu32
+			    " ns, p99 %" PRIu32 " ns, max %" PRIu32 " ns",
+			    names[type], stats.count, stats.min, stats.mean, stats.p99, stats.max);
+
+		for (i = 0; i < BCB_SW_STATS_BUCKETS; i++) {
+			if (stats.buckets[i]) {
+				shell_print(shell, "%12s< %10" PRIu32 " ns: %" PRIu32, "",
+					    bcb_sw_stats_get_bucket_limit(i), stats.buckets[i]);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_boot_handler(const struct shell *shell, size_t argc, char **argv)
+{
+	uint64_t previous = 0;
+	uint64_t time;
+	uint8_t stage;
+
+	for (stage = 0; stage < BCB_BOOT_STAGE_END; stage++) {
+		if (bcb_boot_get_time(stage, &time)) {
+			shell_print(shell, "%-8s: -", bcb_boot_get_stage_name(stage));
+			continue;
+		}
+
+		/* Stages may complete out of order, e.g. the switch closes before the shell. */
+		shell_print(shell, "%-8s: %10" PRIu64 " us (+%" PRIu64 " us)",
+			    bcb_boot_get_stage_name(stage), time, time > previous ? time - previous : 0);
+		previous = time;
+	}
+
+	return 0;
+}
+
+static int cmd_scrub_handler(const struct shell *shell, size_t argc, char **argv)
+{
+	bcb_config_scrub_stats_t stats;
+	int r;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "run")) {
+			shell_print(shell, "%s - [run]", argv[0]);
+			return -EINVAL;
+		}
+
+		r = bcb_config_scrub();
+		if (r) {
+			shell_error(shell, "scrub failed: %d", r);
+			return r;
+		}
+	}
+
+	bcb_config_get_scrub_stats(&stats);
+	shell_print(shell,
+		    "runs %" PRIu32 ", errors %" PRIu32 ", repairs %" PRIu32 ", failures %" PRIu32,
+		    stats.runs, stats.errors, stats.repairs, stats.failures);
+
+	return 0;
+}
+
+static int cmd_journal_handler(const struct shell *shell, size_t argc, char **argv)
+{
+	bcb_journal_event_t event;
+	uint32_t first;
+	uint32_t last;
+	uint32_t seq = 0;
+
+	if (bcb_journal_get_range(&first, &last)) {
+		shell_print(shell, "no events");
+		return 0;
+	}
+
+	if (argc > 1) {
+		/* Only the events after the given sequence number. */
+		seq = strtoul(argv[1], NULL, 10);
+	}
+
+	for (; !bcb_journal_get_next(seq, &event); seq = event.seq) {
+		shell_print(shell, "%8" PRIu32 " %10" PRIu32 " ms %-8s: %3" PRIu8 " %" PRId32,
+			    event.seq, event.uptime, bcb_journal_get_type_name(event.type),
+			    event.arg, event.value);
+	}
 
 	return 0;
 }
@@ -251,6 +471,17 @@ SHELL_STATIC_SUBCMD_SET_CREATE(breaker_sub,
 			       SHELL_CMD(voltage, NULL, "Get voltage.", cmd_voltage_handler),
 			       SHELL_CMD(current, NULL, "Get current.", cmd_current_handler),
 			       SHELL_CMD(frequency, NULL, "Get frequency.", cmd_frequency_handler),
+			       SHELL_CMD(recovery, NULL, "Get/set recovery policy.",
+					 cmd_recovery_handler),
+			       SHELL_CMD(stats, NULL, "Get/reset switching latency statistics.",
+					 cmd_stats_handler),
+			       SHELL_CMD(selftest, NULL, "Get/run scheduled OCP self-tests.",
+					 cmd_selftest_handler),
+			       SHELL_CMD(boot, NULL, "Get boot timeline.", cmd_boot_handler),
+			       SHELL_CMD(journal, NULL, "Get event journal [since].",
+					 cmd_journal_handler),
+			       SHELL_CMD(scrub, NULL, "Get/run EEPROM integrity checks.",
+					 cmd_scrub_handler),
 			       SHELL_CMD(calibrate, &calibrate_sub, "Calibrate measurement system.",
 					 NULL),
 			       SHELL_SUBCMD_SET_END /* Array terminated. */
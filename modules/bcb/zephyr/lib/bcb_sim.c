@@ -1,6 +1,9 @@
 #include <lib/bcb_user_if.h>
+#include <lib/bcb_boot.h>
 #include <lib/bcb_etime.h>
+#include <lib/bcb_timer.h>
 #include <lib/bcb_config.h>
+#include <lib/bcb_journal.h>
 #include <lib/bcb_msmnt.h>
 #include <lib/bcb_zd.h>
 #include <lib/bcb_sw.h>
@@ -8,25 +11,47 @@
 #include <lib/bcb_coap_handlers.h>
 #include <lib/bcb_shell.h>
 #include <lib/bcb.h>
+#include <lib/bcb_tc_def.h>
 #include <init.h>
 
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT_FAST_RESTORE
+BUILD_ASSERT(CONFIG_BCB_LIB_TRIP_CURVE_DEFAULT_INIT_PRIORITY < CONFIG_BCB_LIB_SIM_INIT_PRIORITY,
+	     "Default trip curve must be initialised before the SIM");
+#endif
+
 static int bcb_sim_init()
 {
 	bcb_user_if_init();
 	bcb_etime_init();
+	bcb_boot_init();
+	bcb_timer_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_TIMER);
 	bcb_config_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_CONFIG);
+	bcb_journal_init();
 	bcb_zd_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_ZD);
 	bcb_msmnt_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_MSMNT);
 	bcb_sw_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_SW);
 	bcb_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_BCB);
+
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT_FAST_RESTORE
+	/* Re-close after a power loss before the network services start. */
+	bcb_set_tc(bcb_tc_get_default());
+#endif
 
 #if CONFIG_BCB_COAP
 	bcb_coap_init();
 	bcb_coap_handlers_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_COAP);
 #endif
 
 #if CONFIG_BCB_SHELL
 	bcb_shell_init();
+	bcb_boot_mark(BCB_BOOT_STAGE_SHELL);
 #endif
 	return 0;
 }
@@ -1,8 +1,13 @@
 #include <lib/bcb_sw.h>
+#include <lib/bcb_boot.h>
 #include <lib/bcb_macros.h>
 #include <lib/bcb_config.h>
 #include <lib/bcb_msmnt.h>
 #include <lib/bcb_etime.h>
+#include <lib/bcb_tbase.h>
+#include <lib/bcb_sw_stats.h>
+#include <lib/bcb_timer.h>
+#include <lib/bcb_zd.h>
 #include <device.h>
 #include <kernel.h>
 #include <devicetree.h>
@@ -20,6 +25,33 @@ LOG_MODULE_REGISTER(bcb_sw);
 #define BCB_PWM_DEV(ch_name) (sw_data.dev_pwm_##ch_name)
 #define BCB_DAC_DEV(ch_name) (sw_data.dev_dac_##ch_name)
 
+/* The hardware protection pulls the temperature line of the power out board to ground on
+ * under voltage. Any temperature above this is treated as under voltage.
+ */
+#define SW_UVP_TEMPERATURE 200
+
+typedef enum {
+	SW_SCHED_NONE = 0,
+	SW_SCHED_CLOSE,
+	SW_SCHED_OPEN,
+} sw_sched_action_t;
+
+/* Switch event captured in the GPIO ISR and processed in the system workqueue. */
+struct sw_event {
+	uint64_t etime;
+	uint32_t ic_on;
+	uint32_t ic_off;
+	uint32_t ic_ocp_test;
+	uint16_t raw_t_in;
+	uint16_t raw_t_out;
+	bool is_on;
+	bool is_on_cmd_active;
+	bool is_ocp_test;
+	bcb_ocp_direction_t ocp_test_direction;
+};
+
+K_MSGQ_DEFINE(sw_event_msgq, sizeof(struct sw_event), CONFIG_BCB_LIB_SW_EVENT_QUEUE_SIZE, 4);
+
 struct bcb_sw_data {
 	struct device *dev_gpio_on_off;
 	struct device *dev_gpio_on_off_status;
@@ -37,91 +69,113 @@ struct bcb_sw_data {
 	volatile bool ocp_test_active;
 	volatile bcb_sw_cause_t cause;
 	volatile uint64_t etime_on;
-	volatile uint64_t etime_off;
+	volatile uint64_t etime_close;
+	volatile uint32_t ic_close;
+	volatile bool is_close_timed;
 	volatile uint32_t on_off_duration;
 	volatile uint32_t ocp_test_duration;
-	uint32_t etime_frequency;
-	uint32_t ic_frequency;
+	volatile sw_sched_action_t sched_action;
+	volatile bool is_limit_settling;
+	volatile bool is_close_deferred;
+	bool is_close_deferred_at_zd;
+	bcb_zd_type_t close_deferred_zd_type;
+	bcb_zd_type_t sched_zd_type;
+	uint8_t ocp_limit;
+	bcb_tbase_t ic_r_to_ns;
+	bcb_tbase_t ic_f_to_ns;
+	uint64_t ic_r_period; /* Input capture counter period in elapsed time ticks */
+	int64_t sched_phase_offset;
+	uint16_t raw_t_max;
+	uint16_t raw_t_closing_max;
+	uint16_t raw_t_uvp;
+	volatile bool is_event_lost;
 	struct gpio_callback on_callback;
 	struct gpio_callback off_callback;
 	sys_slist_t callback_list;
+	sys_slist_t ocp_callback_list;
+	struct k_work event_work;
 	struct k_delayed_work vitals_check_work;
+	struct k_delayed_work ocp_limit_work;
+	struct bcb_timer sched_timer;
+	struct bcb_msmnt_window vitals_window_in;
+	struct bcb_msmnt_window vitals_window_out;
 };
 
 static struct bcb_sw_data sw_data;
 
 static void vitals_check_work(struct k_work *work);
+static void ocp_limit_work(struct k_work *work);
+static void on_vitals_window(struct bcb_msmnt_window *window, uint16_t raw);
+static void on_sched_timer(struct bcb_timer *timer);
 
 /**
- * @brief Compare the time duration represented by elapsed time ticks and input capcure time ticks
+ * @brief Get the time duration between on and off events.
  *
- * @param etime	Elapsed time ticks
- * @param ic 	Input capcure time ticks
- * @return int
- * @retval -1	If the duration represented by elapsed time ticks is less than
- *		that of input capcure time ticks.
- * @retval 0	If both ticks represent the same time duration.
- * @retval 1	If the duration represented by elapsed time ticks is higher than
- *		that of input capcure time ticks.
+ * @return uint64_t Time duration in nano seconds
  */
-static inline int etime_ic_ticks_compare(uint64_t etime, uint64_t ic)
+static inline uint32_t get_on_off_duration(const struct sw_event *event)
 {
-	if (sw_data.etime_frequency != sw_data.ic_frequency) {
-		etime *= sw_data.ic_frequency;
-		ic *= sw_data.etime_frequency;
+	uint32_t ic_on = event->ic_on;
+	uint32_t ic_off = event->ic_off;
+	uint32_t ic_duration;
+	uint64_t etime_duration;
+	uint64_t duration;
+
+	ic_duration = ic_on > ic_off ? BCB_IC_COUNTER_MAX(on_off_status_r) - ic_on + ic_off :
+				       ic_off - ic_on;
+
+	etime_duration = sw_data.etime_on > event->etime ?
+				 UINT64_MAX - sw_data.etime_on + event->etime :
+				 event->etime - sw_data.etime_on;
+
+	if (etime_duration < sw_data.ic_r_period) {
+		duration = bcb_tbase_convert(&sw_data.ic_f_to_ns, ic_duration);
+
+	} else {
+		duration = bcb_etime_to_ns(etime_duration);
 	}
 
-	return etime < ic ? -1 : etime > ic;
+	return duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
 }
 
 /**
- * @brief Get the time duration between on and off events.
+ * @brief Get the time duration between the close command and the on event.
  *
- * @return uint64_t Time duration in nano seconds
+ * @return uint32_t Time duration in nano seconds
  */
-static inline uint32_t get_on_off_duration(void)
+static inline uint32_t get_close_duration(const struct sw_event *event)
 {
-	uint32_t ic_on;
-	uint32_t ic_off;
+	uint32_t ic_close = sw_data.ic_close;
+	uint32_t ic_on = event->ic_on;
 	uint32_t ic_duration;
 	uint64_t etime_duration;
 	uint64_t duration;
 
-	ic_on = BCB_IC_VALUE(itimestamp, on_off_status_r);
-	ic_off = BCB_IC_VALUE(itimestamp, on_off_status_f);
-	ic_duration = ic_on > ic_off ? BCB_IC_COUNTER_MAX(on_off_status_r) - ic_on + ic_off :
-				       ic_off - ic_on;
+	ic_duration = ic_close > ic_on ? BCB_IC_COUNTER_MAX(on_off_status_r) - ic_close + ic_on :
+					 ic_on - ic_close;
 
-	etime_duration = sw_data.etime_on > sw_data.etime_off ?
-				 UINT64_MAX - sw_data.etime_on + sw_data.etime_off :
-				 sw_data.etime_off - sw_data.etime_on;
+	etime_duration = sw_data.etime_close > event->etime ?
+				 UINT64_MAX - sw_data.etime_close + event->etime :
+				 event->etime - sw_data.etime_close;
 
-	if (etime_ic_ticks_compare(etime_duration, BCB_IC_COUNTER_MAX(on_off_status_r)) < 0) {
-		duration = (uint64_t)ic_duration * (uint64_t)1e9 /
-			   (uint64_t)BCB_IC_FREQUENCY(on_off_status_f);
+	if (etime_duration < sw_data.ic_r_period) {
+		duration = bcb_tbase_convert(&sw_data.ic_r_to_ns, ic_duration);
 
 	} else {
-		duration = etime_duration * (uint64_t)1e9 / (uint64_t)bcb_etime_get_frequency();
+		duration = bcb_etime_to_ns(etime_duration);
 	}
 
 	return duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
 }
 
-static inline uint32_t get_ocp_test_duration()
+static inline uint32_t get_ocp_test_duration(const struct sw_event *event)
 {
-	uint32_t start;
-	uint32_t end;
+	uint32_t start = event->ic_ocp_test;
+	uint32_t end = event->ic_off;
 	uint64_t duration;
 
-	if (sw_data.ocp_test_direction == BCB_OCP_DIRECTION_POSITIVE) {
-		start = BCB_IC_VALUE(itimestamp, ocp_test_tr_p);
-	} else {
-		start = BCB_IC_VALUE(itimestamp, ocp_test_tr_n);
-	}
-
-	end = BCB_IC_VALUE(itimestamp, on_off_status_f);
 	duration = start > end ? BCB_IC_COUNTER_MAX(on_off_status_f) - start + end : end - start;
-	duration = duration * (uint64_t)1e9 / (uint64_t)BCB_IC_FREQUENCY(on_off_status_f);
+	duration = bcb_tbase_convert(&sw_data.ic_f_to_ns, duration);
 
 	return duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
 }
@@ -131,6 +185,10 @@ static void call_callbacks(bool is_on)
 	bcb_sw_callback_t *callback;
 	bcb_sw_cause_t cause = sw_data.cause;
 
+	if (is_on) {
+		bcb_boot_mark(BCB_BOOT_STAGE_CLOSED);
+	}
+
 	SYS_SLIST_FOR_EACH_CONTAINER (&sw_data.callback_list, callback, node) {
 		if (callback && callback->handler) {
 			callback->handler(is_on, cause);
@@ -138,16 +196,11 @@ static void call_callbacks(bool is_on)
 	}
 }
 
-static void on_event_off(struct device *dev, struct gpio_callback *cb, uint32_t pins)
+static void process_event_off(const struct sw_event *event)
 {
-	sw_data.etime_off = bcb_etime_get_now();
-	bool is_on_cmd_active = BCB_GPIO_PIN_GET_RAW(dctrl, on_off) == 1;
-	int32_t temp_in;
-	int32_t temp_out;
+	sw_data.on_off_duration = get_on_off_duration(event);
 
-	sw_data.on_off_duration = get_on_off_duration();
-
-	if (!is_on_cmd_active) {
+	if (!event->is_on_cmd_active) {
 		LOG_DBG("opened: ext/vitals_check");
 		/* The cause is not set here since the switch might be turned off externally
 		 * or by the vitals check work.
@@ -156,13 +209,10 @@ static void on_event_off(struct device *dev, struct gpio_callback *cb, uint32_t
 		return;
 	}
 
-	if (sw_data.ocp_test_active) {
-		bcb_ocp_test_trigger(BCB_OCP_DIRECTION_POSITIVE, false);
-		bcb_ocp_test_trigger(BCB_OCP_DIRECTION_NEGATIVE, false);
-
-		sw_data.ocp_test_duration = get_ocp_test_duration();
+	if (event->is_ocp_test) {
+		sw_data.ocp_test_duration = get_ocp_test_duration(event);
 		LOG_DBG("opened: ocp test, direction %" PRIu8 ", duration %" PRIu32 " ns",
-			(uint8_t)sw_data.ocp_test_direction, sw_data.ocp_test_duration);
+			(uint8_t)event->ocp_test_direction, sw_data.ocp_test_duration);
 		sw_data.cause = BCB_SW_CAUSE_OCP_TEST;
 		call_callbacks(false);
 		return;
@@ -172,10 +222,7 @@ static void on_event_off(struct device *dev, struct gpio_callback *cb, uint32_t
 	 * The hardware protection has been activated.
 	 */
 
-	temp_in = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_IN);
-	temp_out = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_OUT);
-
-	if (temp_out > 200) {
+	if (event->raw_t_out < sw_data.raw_t_uvp) {
 		/* Under voltage shutdown circuit pulls the temperature line of
 		 * the power out board to ground.
 		 */
@@ -185,10 +232,10 @@ static void on_event_off(struct device *dev, struct gpio_callback *cb, uint32_t
 		return;
 	}
 
-	if (temp_in > CONFIG_BCB_LIB_SW_MAX_TEMPERATURE ||
-	    temp_out > CONFIG_BCB_LIB_SW_MAX_TEMPERATURE) {
+	if (event->raw_t_in < sw_data.raw_t_max || event->raw_t_out < sw_data.raw_t_max) {
 		/* overtemperature protection has been activated. */
-		LOG_DBG("opened: otp, in %" PRId32 " C, out %" PRId32 " C", temp_in, temp_out);
+		LOG_DBG("opened: otp, raw in %" PRIu16 ", out %" PRIu16, event->raw_t_in,
+			event->raw_t_out);
 		sw_data.cause = BCB_SW_CAUSE_OTP;
 		call_callbacks(false);
 		return;
@@ -200,11 +247,99 @@ static void on_event_off(struct device *dev, struct gpio_callback *cb, uint32_t
 	call_callbacks(false);
 }
 
+static void stats_add_off(void)
+{
+	switch (sw_data.cause) {
+	case BCB_SW_CAUSE_EXT:
+		bcb_sw_stats_add(BCB_SW_STATS_ON_OFF_EXT, sw_data.on_off_duration);
+		break;
+	case BCB_SW_CAUSE_OCP:
+		bcb_sw_stats_add(BCB_SW_STATS_ON_OFF_OCP, sw_data.on_off_duration);
+		break;
+	case BCB_SW_CAUSE_OTP:
+		bcb_sw_stats_add(BCB_SW_STATS_ON_OFF_OTP, sw_data.on_off_duration);
+		break;
+	case BCB_SW_CAUSE_UVP:
+		bcb_sw_stats_add(BCB_SW_STATS_ON_OFF_UVP, sw_data.on_off_duration);
+		break;
+	case BCB_SW_CAUSE_OCP_TEST:
+		bcb_sw_stats_add(BCB_SW_STATS_OCP_TEST, sw_data.ocp_test_duration);
+		break;
+	default:
+		break;
+	}
+}
+
+static void event_work(struct k_work *work)
+{
+	struct sw_event event;
+
+	if (sw_data.is_event_lost) {
+		sw_data.is_event_lost = false;
+		LOG_ERR("switch event queue overflow");
+	}
+
+	while (!k_msgq_get(&sw_event_msgq, &event, K_NO_WAIT)) {
+		if (event.is_on) {
+			sw_data.etime_on = event.etime;
+			if (sw_data.is_close_timed) {
+				sw_data.is_close_timed = false;
+				bcb_sw_stats_add(BCB_SW_STATS_CLOSE, get_close_duration(&event));
+			}
+			LOG_DBG("closed: ext");
+			call_callbacks(true);
+		} else {
+			process_event_off(&event);
+			stats_add_off();
+		}
+	}
+}
+
+static inline void event_put(const struct sw_event *event)
+{
+	if (k_msgq_put(&sw_event_msgq, event, K_NO_WAIT)) {
+		sw_data.is_event_lost = true;
+	}
+
+	k_work_submit(&sw_data.event_work);
+}
+
+/* Only captures the event. Classification is done in event_work(). */
+static void on_event_off(struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+	struct sw_event event;
+
+	event.etime = bcb_etime_get_now();
+	event.ic_on = BCB_IC_VALUE(itimestamp, on_off_status_r);
+	event.ic_off = BCB_IC_VALUE(itimestamp, on_off_status_f);
+	event.raw_t_in = bcb_msmnt_get_raw(BCB_MSMNT_TYPE_T_PWR_IN);
+	event.raw_t_out = bcb_msmnt_get_raw(BCB_MSMNT_TYPE_T_PWR_OUT);
+	event.is_on = false;
+	event.is_on_cmd_active = BCB_GPIO_PIN_GET_RAW(dctrl, on_off) == 1;
+	event.is_ocp_test = event.is_on_cmd_active && sw_data.ocp_test_active;
+	event.ocp_test_direction = sw_data.ocp_test_direction;
+	event.ic_ocp_test = 0;
+
+	if (event.is_ocp_test) {
+		event.ic_ocp_test = event.ocp_test_direction == BCB_OCP_DIRECTION_POSITIVE ?
+					    BCB_IC_VALUE(itimestamp, ocp_test_tr_p) :
+					    BCB_IC_VALUE(itimestamp, ocp_test_tr_n);
+		bcb_ocp_test_trigger(BCB_OCP_DIRECTION_POSITIVE, false);
+		bcb_ocp_test_trigger(BCB_OCP_DIRECTION_NEGATIVE, false);
+	}
+
+	event_put(&event);
+}
+
 static void on_event_on(struct device *dev, struct gpio_callback *cb, uint32_t pins)
 {
-	sw_data.etime_on = bcb_etime_get_now();
-	LOG_DBG("closed: ext");
-	call_callbacks(true);
+	struct sw_event event;
+
+	event.etime = bcb_etime_get_now();
+	event.ic_on = BCB_IC_VALUE(itimestamp, on_off_status_r);
+	event.is_on = true;
+
+	event_put(&event);
 }
 
 int bcb_sw_init(void)
@@ -265,46 +400,118 @@ int bcb_sw_init(void)
 	BCB_DAC_INIT(actrl, ocp_limit_adj);
 	BCB_DAC_SET(actrl, ocp_limit_adj, 4095);
 
-	sw_data.etime_frequency = bcb_etime_get_frequency();
-	sw_data.ic_frequency = input_capture_get_frequency(BCB_IC_DEV(on_off_status_r));
+	/* Durations are measured in switching interrupts, hence no divisions there. */
+	bcb_tbase_init(&sw_data.ic_r_to_ns, BCB_IC_FREQUENCY(on_off_status_r), 1000000000);
+	bcb_tbase_init(&sw_data.ic_f_to_ns, BCB_IC_FREQUENCY(on_off_status_f), 1000000000);
+	sw_data.ic_r_period = (uint64_t)BCB_IC_COUNTER_MAX(on_off_status_r) *
+			      bcb_etime_get_frequency() / BCB_IC_FREQUENCY(on_off_status_r);
+	sw_data.sched_phase_offset = (int64_t)bcb_etime_from_us(
+		CONFIG_BCB_LIB_SW_ZD_PHASE_OFFSET < 0 ? -CONFIG_BCB_LIB_SW_ZD_PHASE_OFFSET :
+							CONFIG_BCB_LIB_SW_ZD_PHASE_OFFSET);
+	if (CONFIG_BCB_LIB_SW_ZD_PHASE_OFFSET < 0) {
+		sw_data.sched_phase_offset = -sw_data.sched_phase_offset;
+	}
+
+	sw_data.raw_t_max = bcb_msmnt_temp_to_raw(BCB_TEMP_SENSOR_PWR_IN,
+						  CONFIG_BCB_LIB_SW_MAX_TEMPERATURE);
+	sw_data.raw_t_closing_max = bcb_msmnt_temp_to_raw(BCB_TEMP_SENSOR_PWR_IN,
+							  CONFIG_BCB_LIB_SW_MAX_CLOSING_TEMPERATURE);
+	sw_data.raw_t_uvp = bcb_msmnt_temp_to_raw(BCB_TEMP_SENSOR_PWR_OUT, SW_UVP_TEMPERATURE);
 
+	k_work_init(&sw_data.event_work, event_work);
+	bcb_timer_setup(&sw_data.sched_timer, on_sched_timer, false);
 	k_delayed_work_init(&sw_data.vitals_check_work, vitals_check_work);
+	k_delayed_work_init(&sw_data.ocp_limit_work, ocp_limit_work);
+
+	/* Both OTP and UVP read lower than the OTP threshold. */
+	sw_data.vitals_window_in.type = BCB_MSMNT_TYPE_T_PWR_IN;
+	sw_data.vitals_window_in.low = sw_data.raw_t_max;
+	sw_data.vitals_window_in.high = UINT16_MAX;
+	sw_data.vitals_window_in.handler = on_vitals_window;
+	bcb_msmnt_add_window(&sw_data.vitals_window_in);
+
+	sw_data.vitals_window_out.type = BCB_MSMNT_TYPE_T_PWR_OUT;
+	sw_data.vitals_window_out.low = sw_data.raw_t_max;
+	sw_data.vitals_window_out.high = UINT16_MAX;
+	sw_data.vitals_window_out.handler = on_vitals_window;
+	bcb_msmnt_add_window(&sw_data.vitals_window_out);
 
 	return 0;
 }
 
-static int bcb_sw_close(void)
+static int sw_close_check(void)
 {
-	int32_t temp_in;
-	int32_t temp_out;
+	uint16_t raw_t_in;
+	uint16_t raw_t_out;
 
-	if (bcb_sw_is_on()) {
-		return 0;
-	}
+	raw_t_in = bcb_msmnt_get_raw(BCB_MSMNT_TYPE_T_PWR_IN);
+	raw_t_out = bcb_msmnt_get_raw(BCB_MSMNT_TYPE_T_PWR_OUT);
 
-	temp_in = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_IN);
-	temp_out = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_OUT);
-
-	if (temp_out > 200) {
+	if (raw_t_out < sw_data.raw_t_uvp) {
 		sw_data.cause = BCB_SW_CAUSE_UVP;
 		return -EACCES;
 	}
 
-	if (temp_in > CONFIG_BCB_LIB_SW_MAX_CLOSING_TEMPERATURE ||
-	    temp_out > CONFIG_BCB_LIB_SW_MAX_CLOSING_TEMPERATURE) {
+	if (raw_t_in < sw_data.raw_t_closing_max || raw_t_out < sw_data.raw_t_closing_max) {
 		sw_data.cause = BCB_SW_CAUSE_OTP;
 		return -EACCES;
 	}
 
+	return 0;
+}
+
+/* Can be called from an ISR. */
+static void sw_close_now(void)
+{
 	LOG_DBG("closing");
 	sw_data.cause = BCB_SW_CAUSE_EXT;
 	BCB_GPIO_PIN_SET_RAW(dctrl, ocp_otp_reset, 0);
 	BCB_GPIO_PIN_SET_RAW(dctrl, ocp_otp_reset, 1);
 	BCB_GPIO_PIN_SET_RAW(dctrl, ocp_otp_reset, 0);
+	sw_data.etime_close = bcb_etime_get_now();
+	sw_data.ic_close = BCB_IC_COUNTER(on_off_status_r);
+	sw_data.is_close_timed = true;
 	BCB_GPIO_PIN_SET_RAW(dctrl, on_off, 1);
 
 	k_delayed_work_submit(&sw_data.vitals_check_work,
 			      K_MSEC(CONFIG_BCB_LIB_SW_VITALS_CHECK_INTERVAL));
+}
+
+/* Can be called from an ISR. Closing waits until a new OCP limit has taken effect. */
+static bool sw_close_defer(bool is_at_zd, bcb_zd_type_t type)
+{
+	if (!sw_data.is_limit_settling) {
+		return false;
+	}
+
+	LOG_DBG("closing deferred");
+	sw_data.close_deferred_zd_type = type;
+	sw_data.is_close_deferred_at_zd = is_at_zd;
+	sw_data.is_close_deferred = true;
+
+	return true;
+}
+
+static int bcb_sw_close(void)
+{
+	int r;
+
+	bcb_sw_cancel_scheduled();
+
+	if (bcb_sw_is_on()) {
+		return 0;
+	}
+
+	r = sw_close_check();
+	if (r) {
+		return r;
+	}
+
+	if (sw_close_defer(false, BCB_ZD_TYPE_VOLTAGE)) {
+		return 0;
+	}
+
+	sw_close_now();
 
 	return 0;
 }
@@ -314,12 +521,9 @@ int bcb_sw_on(void)
 	return bcb_sw_close();
 }
 
-static int sw_open(void)
+/* Can be called from an ISR. */
+static void sw_open_now(bcb_sw_cause_t cause)
 {
-	if (!bcb_sw_is_on()) {
-		return 0;
-	}
-
 	if (sw_data.ocp_test_active) {
 		bcb_ocp_test_trigger(BCB_OCP_DIRECTION_POSITIVE, false);
 		bcb_ocp_test_trigger(BCB_OCP_DIRECTION_NEGATIVE, false);
@@ -327,15 +531,27 @@ static int sw_open(void)
 
 	LOG_DBG("opening");
 	k_delayed_work_cancel(&sw_data.vitals_check_work);
-	sw_data.cause = BCB_SW_CAUSE_EXT;
+	sw_data.cause = cause;
 	BCB_GPIO_PIN_SET_RAW(dctrl, on_off, 0);
+}
+
+/* Can be called from an ISR. */
+static int sw_open(bcb_sw_cause_t cause)
+{
+	bcb_sw_cancel_scheduled();
+
+	if (!bcb_sw_is_on()) {
+		return 0;
+	}
+
+	sw_open_now(cause);
 
 	return 0;
 }
 
 int bcb_sw_off(void)
 {
-	return sw_open();
+	return sw_open(BCB_SW_CAUSE_EXT);
 }
 
 bool bcb_sw_is_on()
@@ -343,6 +559,128 @@ bool bcb_sw_is_on()
 	return BCB_GPIO_PIN_GET_RAW(dctrl, on_off_status) == 1;
 }
 
+static void on_sched_timer(struct bcb_timer *timer)
+{
+	sw_sched_action_t action = sw_data.sched_action;
+
+	sw_data.sched_action = SW_SCHED_NONE;
+
+	if (action == SW_SCHED_CLOSE && !bcb_sw_is_on()) {
+		/* The limit may have been changed after closing was scheduled. */
+		if (!sw_close_defer(true, sw_data.sched_zd_type)) {
+			sw_close_now();
+		}
+	} else if (action == SW_SCHED_OPEN && bcb_sw_is_on()) {
+		sw_open_now(BCB_SW_CAUSE_EXT);
+	}
+}
+
+static int sw_schedule(sw_sched_action_t action, uint64_t etime)
+{
+	unsigned int key;
+	int r;
+
+	key = irq_lock();
+	r = bcb_timer_start_at(&sw_data.sched_timer, etime);
+	if (!r) {
+		sw_data.sched_action = action;
+	}
+	irq_unlock(key);
+
+	return r;
+}
+
+static int sw_schedule_at_zd(sw_sched_action_t action, bcb_zd_type_t type)
+{
+	uint64_t etime;
+	int r;
+
+	if (!IS_ENABLED(CONFIG_BCB_LIB_SW_ZD_PREDICTIVE)) {
+		return -ENOTSUP;
+	}
+
+	r = bcb_zd_get_next_crossing(type, &etime);
+	if (r) {
+		return r;
+	}
+
+	if (type == BCB_ZD_TYPE_VOLTAGE) {
+		/* Current zero-crossings are interpolated from samples and hence have no
+		 * detector delay to be compensated.
+		 */
+		etime += sw_data.sched_phase_offset;
+	}
+
+	sw_data.sched_zd_type = type;
+
+	return sw_schedule(action, etime);
+}
+
+int bcb_sw_on_at_zd(bcb_zd_type_t type)
+{
+	int r;
+
+	if (sw_data.sched_action == SW_SCHED_CLOSE) {
+		return 0;
+	}
+
+	if (bcb_sw_is_on()) {
+		bcb_sw_cancel_scheduled();
+		return 0;
+	}
+
+	r = sw_close_check();
+	if (r) {
+		return r;
+	}
+
+	if (sw_close_defer(true, type)) {
+		return 0;
+	}
+
+	if (sw_schedule_at_zd(SW_SCHED_CLOSE, type)) {
+		/* Zero-crossing cannot be predicted. Fallback to closing immediately. */
+		return bcb_sw_close();
+	}
+
+	return 0;
+}
+
+int bcb_sw_off_at_zd(bcb_zd_type_t type)
+{
+	if (sw_data.sched_action == SW_SCHED_OPEN) {
+		return 0;
+	}
+
+	if (!bcb_sw_is_on()) {
+		bcb_sw_cancel_scheduled();
+		return 0;
+	}
+
+	if (sw_schedule_at_zd(SW_SCHED_OPEN, type)) {
+		/* Zero-crossing cannot be predicted. Fallback to opening immediately. */
+		return sw_open(BCB_SW_CAUSE_EXT);
+	}
+
+	return 0;
+}
+
+void bcb_sw_cancel_scheduled(void)
+{
+	unsigned int key;
+
+	sw_data.is_close_deferred = false;
+
+	if (sw_data.sched_action == SW_SCHED_NONE) {
+		return;
+	}
+
+	key = irq_lock();
+	bcb_timer_stop(&sw_data.sched_timer);
+	sw_data.sched_action = SW_SCHED_NONE;
+	irq_unlock(key);
+}
+
 bcb_sw_cause_t bcb_sw_get_cause(void)
 {
 	return sw_data.cause;
@@ -397,12 +735,71 @@ int bcb_ocp_set_limit(uint8_t current)
 	}
 
 	BCB_DAC_SET(actrl, ocp_limit_adj, (uint32_t)dac);
-	/* It takes ~200 ms for the new OCP limit to take effect. */
-	k_sleep(K_MSEC(200));
+	sw_data.ocp_limit = current;
+	sw_data.is_limit_settling = true;
+	/* It takes some time for the new OCP limit to take effect. A pending settling period is
+	 * restarted since the previous limit has not taken effect either.
+	 */
+	k_delayed_work_submit(&sw_data.ocp_limit_work,
+			      K_MSEC(CONFIG_BCB_LIB_OCP_LIMIT_SETTLING_TIME));
 
 	return 0;
 }
 
+bool bcb_ocp_is_limit_settling(void)
+{
+	return sw_data.is_limit_settling;
+}
+
+static void ocp_limit_work(struct k_work *work)
+{
+	bcb_ocp_callback_t *callback;
+	int r;
+
+	LOG_DBG("limit settled: %" PRIu8, sw_data.ocp_limit);
+	sw_data.is_limit_settling = false;
+
+	if (sw_data.is_close_deferred) {
+		sw_data.is_close_deferred = false;
+
+		if (sw_data.is_close_deferred_at_zd) {
+			r = bcb_sw_on_at_zd(sw_data.close_deferred_zd_type);
+		} else {
+			r = bcb_sw_close();
+		}
+
+		if (r) {
+			LOG_WRN("cannot close deferred: %d", r);
+		}
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER (&sw_data.ocp_callback_list, callback, node) {
+		if (callback && callback->handler) {
+			callback->handler(sw_data.ocp_limit);
+		}
+	}
+}
+
+int bcb_ocp_add_callback(bcb_ocp_callback_t *callback)
+{
+	if (!callback || !callback->handler) {
+		return -ENOTSUP;
+	}
+
+	sys_slist_append(&sw_data.ocp_callback_list, &callback->node);
+
+	return 0;
+}
+
+void bcb_ocp_remove_callback(bcb_ocp_callback_t *callback)
+{
+	if (!callback) {
+		return;
+	}
+
+	sys_slist_find_and_remove(&sw_data.ocp_callback_list, &callback->node);
+}
+
 uint32_t bcb_sw_get_on_off_duration(void)
 {
 	return sw_data.on_off_duration;
@@ -433,30 +830,45 @@ void bcb_sw_remove_callback(bcb_sw_callback_t *callback)
 	sys_slist_find_and_remove(&sw_data.callback_list, &callback->node);
 }
 
-static void vitals_check_work(struct k_work *work)
+/* Can be called from an ISR. */
+static bool vitals_check(void)
 {
-	int32_t temp_in;
-	int32_t temp_out;
+	uint16_t raw_t_in;
+	uint16_t raw_t_out;
 
-	temp_in = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_IN);
-	temp_out = bcb_msmnt_get_temp(BCB_TEMP_SENSOR_PWR_OUT);
+	raw_t_in = bcb_msmnt_get_raw(BCB_MSMNT_TYPE_T_PWR_IN);
+	raw_t_out = bcb_msmnt_get_raw(BCB_MSMNT_TYPE_T_PWR_OUT);
 
-	if (temp_out > 200) {
+	if (raw_t_out < sw_data.raw_t_uvp) {
 		LOG_DBG("vitals_check: uvp");
-		sw_data.cause = BCB_SW_CAUSE_UVP;
-		sw_open();
-		return;
+		sw_open(BCB_SW_CAUSE_UVP);
+		return false;
 	}
 
-	if (temp_in > CONFIG_BCB_LIB_SW_MAX_TEMPERATURE ||
-	    temp_out > CONFIG_BCB_LIB_SW_MAX_TEMPERATURE) {
-		LOG_DBG("vitals_check: otp: in %" PRId32 " C, out %" PRId32 " C", temp_in,
-			temp_out);
-		sw_data.cause = BCB_SW_CAUSE_OTP;
-		sw_open();
+	if (raw_t_in < sw_data.raw_t_max || raw_t_out < sw_data.raw_t_max) {
+		LOG_DBG("vitals_check: otp: raw in %" PRIu16 ", out %" PRIu16, raw_t_in,
+			raw_t_out);
+		sw_open(BCB_SW_CAUSE_OTP);
+		return false;
+	}
+
+	return true;
+}
+
+static void on_vitals_window(struct bcb_msmnt_window *window, uint16_t raw)
+{
+	if (BCB_GPIO_PIN_GET_RAW(dctrl, on_off) != 1) {
 		return;
 	}
 
-	k_delayed_work_submit(&sw_data.vitals_check_work,
-			      K_MSEC(CONFIG_BCB_LIB_SW_VITALS_CHECK_INTERVAL));
+	vitals_check();
+}
+
+static void vitals_check_work(struct k_work *work)
+{
+	/* Backstop for the window comparison done on every ADC1 conversion sequence. */
+	if (vitals_check()) {
+		k_delayed_work_submit(&sw_data.vitals_check_work,
+				      K_MSEC(CONFIG_BCB_LIB_SW_VITALS_CHECK_INTERVAL));
+	}
 }
@@ -0,0 +1,118 @@
+#include <lib/bcb_sw_stats.h>
+#include <zephyr.h>
+#include <string.h>
+#include <errno.h>
+
+// clang-format off
+#define BUCKET_SHIFT            8
+// clang-format on
+
+struct sw_stats_hist {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t buckets[BCB_SW_STATS_BUCKETS];
+};
+
+static struct sw_stats_hist stats_data[BCB_SW_STATS_END];
+
+static inline uint8_t get_bucket(uint32_t duration)
+{
+	uint8_t bucket;
+
+	if (duration >> BUCKET_SHIFT == 0) {
+		return 0;
+	}
+
+	/* Floor of log2 */
+	bucket = 31 - __builtin_clz(duration) - BUCKET_SHIFT;
+
+	return bucket < BCB_SW_STATS_BUCKETS ? bucket : BCB_SW_STATS_BUCKETS - 1;
+}
+
+uint32_t bcb_sw_stats_get_bucket_limit(uint8_t bucket)
+{
+	if (bucket + BUCKET_SHIFT + 1 >= 32) {
+		return UINT32_MAX;
+	}
+
+	return (uint32_t)1 << (bucket + BUCKET_SHIFT + 1);
+}
+
+void bcb_sw_stats_add(bcb_sw_stats_type_t type, uint32_t duration)
+{
+	struct sw_stats_hist *hist;
+	unsigned int key;
+
+	if (type >= BCB_SW_STATS_END) {
+		return;
+	}
+
+	hist = &stats_data[type];
+
+	key = irq_lock();
+	if (!hist->count || duration < hist->min) {
+		hist->min = duration;
+	}
+
+	if (duration > hist->max) {
+		hist->max = duration;
+	}
+
+	hist->count++;
+	hist->sum += duration;
+	hist->buckets[get_bucket(duration)]++;
+	irq_unlock(key);
+}
+
+int bcb_sw_stats_get(bcb_sw_stats_type_t type, bcb_sw_stats_t *stats)
+{
+	struct sw_stats_hist hist;
+	unsigned int key;
+	uint32_t rank;
+	uint32_t cumulative;
+	uint8_t i;
+
+	if (type >= BCB_SW_STATS_END || !stats) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+	hist = stats_data[type];
+	irq_unlock(key);
+
+	memset(stats, 0, sizeof(bcb_sw_stats_t));
+	memcpy(stats->buckets, hist.buckets, sizeof(stats->buckets));
+
+	if (!hist.count) {
+		return 0;
+	}
+
+	stats->count = hist.count;
+	stats->min = hist.min;
+	stats->max = hist.max;
+	stats->mean = (uint32_t)(hist.sum / hist.count);
+
+	rank = (uint32_t)(((uint64_t)hist.count * 99 + 99) / 100);
+	cumulative = 0;
+	for (i = 0; i < BCB_SW_STATS_BUCKETS; i++) {
+		cumulative += hist.buckets[i];
+		if (cumulative >= rank) {
+			break;
+		}
+	}
+
+	stats->p99 = MIN(bcb_sw_stats_get_bucket_limit(i), hist.max);
+
+	return 0;
+}
+
+void bcb_sw_stats_reset(void)
+{
+	unsigned int key;
+
+	key = irq_lock();
+	memset(stats_data, 0, sizeof(stats_data));
+	irq_unlock(key);
+}
@@ -0,0 +1,39 @@
+#include <lib/bcb_tbase.h>
+#include <errno.h>
+
+int bcb_tbase_init(bcb_tbase_t *tbase, uint32_t from, uint32_t to)
+{
+	uint64_t mult;
+	uint64_t rem;
+	uint8_t shift;
+
+	if (!from || !to) {
+		return -EINVAL;
+	}
+
+	/* Long division producing fraction bits until the multiplier has 64 significant bits.
+	 * The ratio is at least 2^-32, so the shift stays below 96.
+	 */
+	mult = to / from;
+	rem = to % from;
+	shift = 0;
+	while (mult < ((uint64_t)1 << 63)) {
+		rem <<= 1;
+		mult <<= 1;
+		if (rem >= from) {
+			rem -= from;
+			mult |= 1;
+		}
+		shift++;
+	}
+
+	/* Round to the nearest. */
+	if (rem << 1 >= from && mult != UINT64_MAX) {
+		mult++;
+	}
+
+	tbase->mult = mult;
+	tbase->shift = shift;
+
+	return 0;
+}
@@ -1,8 +1,10 @@
 #include <lib/bcb_tc_def.h>
 #include <lib/bcb_tc.h>
 #include <lib/bcb_tc_def_msm.h>
+#include <lib/bcb_tc_def_ocpt.h>
 #include <lib/bcb_common.h>
 #include <lib/bcb_config.h>
+#include <lib/bcb_journal.h>
 #include <lib/bcb.h>
 #include <lib/bcb_sw.h>
 #include <lib/bcb_zd.h>
@@ -13,7 +15,9 @@
 #include <string.h>
 
 // clang-format off
-#define CONFIG_OFFSET		CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_TC_DEF
+#define CONFIG_VERSION		1
+#define SNAPSHOT_VERSION	1
+#define SNAPSHOT_INTERVAL	CONFIG_BCB_TRIP_CURVE_DEFAULT_SNAPSHOT_INTERVAL
 #define MONITOR_WORK_INTERVAL	CONFIG_BCB_TRIP_CURVE_DEFAULT_MONITOR_INTERVAL
 #define MAX_CURVE_POINTS	CONFIG_BCB_TRIP_CURVE_DEFAULT_MAX_POINTS
 #define LOG_LEVEL 		CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
@@ -28,20 +32,35 @@ typedef struct tc_def_config {
 	uint8_t limit_hw; /**< Hardware current limit. */
 } tc_def_config_t;
 
+/* State restored when the switch is re-closed after a power loss. */
+typedef struct __attribute__((packed)) tc_def_snapshot {
+	uint8_t supply; /**< Supply type (bcb_tc_def_msm_supply_t). */
+	uint8_t num_points; /**< Number of points the spent durations belong to. */
+	uint16_t spent_intervals[MAX_CURVE_POINTS]; /**< Spent durations in monitor intervals. */
+} tc_def_snapshot_t;
+
 struct curve_data {
 	bool initialized;
+	bool is_restoring; /* The next close re-closes with the snapshot state */
+	bool is_snapshot_dirty; /* Spent durations changed after the last snapshot */
+	int64_t snapshot_time;
 	tc_def_config_t config;
+	tc_def_snapshot_t snapshot;
 	uint32_t spent_duration[MAX_CURVE_POINTS];
 	struct k_delayed_work monitor_work;
 	struct k_work callback_work;
 	bcb_tc_callback_handler_t callback;
 	struct bcb_zd_callback zd_callback;
+	struct bcb_zd_callback zd_i_callback;
 	struct bcb_sw_callback sw_callback;
+	struct bcb_ocp_callback ocp_callback;
 };
 
 static struct curve_data curve_data;
 const struct bcb_tc trip_curve_default;
 
+static bcb_tc_cause_t trip_curve_get_cause(void);
+
 static inline void curve_reset()
 {
 	int i;
@@ -51,6 +70,75 @@ static inline void curve_reset()
 	}
 }
 
+BCB_CONFIG_LOG_ASSERT_SIZE(TC_DEF_SNAPSHOT, sizeof(tc_def_snapshot_t));
+
+static inline bool is_snapshot_reset(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_CURVE_POINTS; i++) {
+		if (curve_data.snapshot.spent_intervals[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void store_snapshot(void)
+{
+	int i;
+	int r;
+
+	curve_data.snapshot.supply = bcb_tc_def_msm_get_supply();
+	curve_data.snapshot.num_points = curve_data.config.num_points;
+	for (i = 0; i < MAX_CURVE_POINTS; i++) {
+		curve_data.snapshot.spent_intervals[i] =
+			MIN(curve_data.spent_duration[i] / MONITOR_WORK_INTERVAL, UINT16_MAX);
+	}
+	curve_data.is_snapshot_dirty = false;
+	curve_data.snapshot_time = k_uptime_get();
+
+	r = bcb_config_log_store(BCB_CONFIG_LOG_ID_TC_DEF_SNAPSHOT, SNAPSHOT_VERSION,
+				 (uint8_t *)&curve_data.snapshot, sizeof(tc_def_snapshot_t));
+	if (r) {
+		LOG_ERR("cannot store snapshot: %d", r);
+	}
+}
+
+static void restore_snapshot(void)
+{
+	int i;
+	int r;
+
+	curve_data.is_restoring = false;
+
+	r = bcb_config_log_load(BCB_CONFIG_LOG_ID_TC_DEF_SNAPSHOT, SNAPSHOT_VERSION,
+				(uint8_t *)&curve_data.snapshot, sizeof(tc_def_snapshot_t), NULL);
+	if (r) {
+		LOG_WRN("cannot restore snapshot: %d", r);
+		memset(&curve_data.snapshot, 0, sizeof(tc_def_snapshot_t));
+		return;
+	}
+
+	if (curve_data.snapshot.supply >= BCB_TC_DEF_MSM_SUPPLY_END) {
+		curve_data.snapshot.supply = BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
+	}
+
+	/* Spent durations of a different curve cannot be used. */
+	if (curve_data.snapshot.num_points == curve_data.config.num_points) {
+		for (i = 0; i < MAX_CURVE_POINTS; i++) {
+			curve_data.spent_duration[i] =
+				(uint32_t)curve_data.snapshot.spent_intervals[i] *
+				MONITOR_WORK_INTERVAL;
+		}
+	} else {
+		curve_reset();
+	}
+
+	curve_data.is_restoring = true;
+}
+
 static void on_monitor_work(struct k_work *work)
 {
 	int i;
@@ -62,6 +150,9 @@ static void on_monitor_work(struct k_work *work)
 	}
 
 	if (current < curve_data.config.points[0].i) {
+		if (curve_data.is_snapshot_dirty) {
+			store_snapshot();
+		}
 		goto shedule_monitor;
 	}
 
@@ -83,6 +174,11 @@ static void on_monitor_work(struct k_work *work)
 		/* Nothing to be done in here. */
 	}
 
+	curve_data.is_snapshot_dirty = true;
+	if (k_uptime_get() - curve_data.snapshot_time >= SNAPSHOT_INTERVAL) {
+		store_snapshot();
+	}
+
 shedule_monitor:
 	k_delayed_work_submit(&curve_data.monitor_work, K_MSEC(MONITOR_WORK_INTERVAL));
 }
@@ -140,20 +236,92 @@ static void on_zd_voltage(void)
 	bcb_tc_def_msm_event(BCB_TC_DEF_EV_ZD_V, NULL);
 }
 
+static void on_zd_current(void)
+{
+	bcb_tc_def_msm_event(BCB_TC_DEF_EV_ZD_I, NULL);
+}
+
+static void journal_on_opened(bcb_sw_cause_t cause)
+{
+	switch (bcb_tc_def_msm_get_state()) {
+	case BCB_TC_DEF_MSM_STATE_OPENED:
+		if (bcb_tc_def_msm_get_cause() != BCB_TC_DEF_MSM_CAUSE_NONE &&
+		    bcb_tc_def_msm_get_cause() != BCB_TC_DEF_MSM_CAUSE_EXT) {
+			bcb_journal_add_trip(BCB_JOURNAL_TYPE_TRIP, trip_curve_get_cause());
+		}
+		break;
+	case BCB_TC_DEF_MSM_STATE_CLOSE_WAIT:
+		/* Self-tests re-close too, but they are recorded with their results. */
+		if (cause == BCB_SW_CAUSE_OCP) {
+			bcb_journal_add_trip(BCB_JOURNAL_TYPE_RECOVERY, BCB_TC_CAUSE_OCP_HW);
+		}
+		break;
+	default:
+		/* Opened by a closed-state operation mode. */
+		break;
+	}
+}
+
 static void on_switch_changed(bool is_closed, bcb_sw_cause_t cause)
 {
 	if (is_closed) {
 		bcb_tc_def_msm_event(BCB_TC_DEF_EV_SW_CLOSED, NULL);
+		/* The supply type is known once the switch has been closed. */
+		if (bcb_tc_def_msm_get_supply() != curve_data.snapshot.supply) {
+			store_snapshot();
+		}
 	} else {
 		bcb_tc_def_msm_event(BCB_TC_DEF_EV_SW_OPENED, NULL);
+		journal_on_opened(cause);
+	}
+}
+
+static void on_ocp_limit_settled(uint8_t current)
+{
+	LOG_INF("hw limit: %" PRIu8, current);
+}
+
+BCB_CONFIG_ASSERT_SIZE(TC_DEF, sizeof(tc_def_config_t));
+
+/* Version 0 has the same layout, but the number of points is the one of the firmware that stored
+ * it.
+ */
+static int migrate_config(uint8_t version, const uint8_t *stored, size_t stored_size,
+			  uint8_t *data, size_t size)
+{
+	tc_def_config_t *config = (tc_def_config_t *)data;
+	size_t max_points;
+	uint8_t num_points;
+
+	if (version != 0) {
+		return -EINVAL;
+	}
+
+	/* Trailing padding is smaller than a point. */
+	max_points = stored_size / sizeof(bcb_tc_pt_t);
+	if (stored_size < max_points * sizeof(bcb_tc_pt_t) + 2) {
+		return -EINVAL;
+	}
+
+	num_points = stored[max_points * sizeof(bcb_tc_pt_t)];
+	if (num_points > max_points || num_points > MAX_CURVE_POINTS) {
+		LOG_ERR("cannot migrate %" PRIu8 " points", num_points);
+		return -EINVAL;
 	}
+
+	memcpy(config->points, stored, num_points * sizeof(bcb_tc_pt_t));
+	config->num_points = num_points;
+	config->limit_hw = stored[max_points * sizeof(bcb_tc_pt_t) + 1];
+
+	return 0;
 }
 
 static int restore_config(void)
 {
 	int r;
 
-	r = bcb_config_load(CONFIG_OFFSET, (uint8_t *)&curve_data.config, sizeof(tc_def_config_t));
+	r = bcb_config_load(BCB_CONFIG_ID_TC_DEF, CONFIG_VERSION, (uint8_t *)&curve_data.config,
+			    sizeof(tc_def_config_t), migrate_config);
 	if (r) {
 		LOG_ERR("cannot restore params: %d", r);
 	}
@@ -165,7 +333,8 @@ static int store_config(void)
 {
 	int r;
 
-	r = bcb_config_store(CONFIG_OFFSET, (uint8_t *)&curve_data.config, sizeof(tc_def_config_t));
+	r = bcb_config_store(BCB_CONFIG_ID_TC_DEF, CONFIG_VERSION, (uint8_t *)&curve_data.config,
+			     sizeof(tc_def_config_t));
 	if (r) {
 		LOG_ERR("cannot store params: %d", r);
 	}
@@ -175,20 +344,24 @@ static int store_config(void)
 
 static int trip_curve_init(void)
 {
+	/* Defaults are kept for the fields an older stored config does not have. */
+	load_default_config();
 	if (restore_config()) {
-		/* Restoring could fail while trying to load old parameters. 
-		   So store default values into the config to avoid future errors.
-		   NOTE: This effectively overwrites the old parameters.
-		 */
-		load_default_config();
 		store_config();
 	}
 
+	restore_snapshot();
+
+	curve_data.ocp_callback.handler = on_ocp_limit_settled;
+	bcb_ocp_add_callback(&curve_data.ocp_callback);
+	/* Closing is deferred by the switch until the limit has settled. */
 	bcb_ocp_set_limit(curve_data.config.limit_hw);
 
 	curve_data.zd_callback.handler = on_zd_voltage;
+	curve_data.zd_i_callback.handler = on_zd_current;
 	curve_data.sw_callback.handler = on_switch_changed;
 	bcb_zd_add_callback(BCB_ZD_TYPE_VOLTAGE, &curve_data.zd_callback);
+	bcb_zd_add_callback(BCB_ZD_TYPE_CURRENT, &curve_data.zd_i_callback);
 	bcb_sw_add_callback(&curve_data.sw_callback);
 
 	bcb_tc_def_msm_init(&curve_data.callback_work);
@@ -204,7 +377,11 @@ static int trip_curve_shutdown(void)
 {
 	curve_data.initialized = false;
 	bcb_zd_remove_callback(BCB_ZD_TYPE_VOLTAGE, &curve_data.zd_callback);
+	bcb_zd_remove_callback(BCB_ZD_TYPE_CURRENT, &curve_data.zd_i_callback);
 	bcb_sw_remove_callback(&curve_data.sw_callback);
+	bcb_ocp_remove_callback(&curve_data.ocp_callback);
+	/* Started by the main state machine, which has no shutdown of its own. */
+	bcb_tc_def_ocpt_shutdown();
 
 	LOG_INF("shutdown");
 
@@ -217,7 +394,18 @@ static int trip_curve_close(void)
 		return -ENOTSUP;
 	}
 
-	curve_reset();
+	if (curve_data.is_restoring) {
+		/* Re-closing after a power loss. The load is not assumed to have cooled down. */
+		curve_data.is_restoring = false;
+		bcb_tc_def_msm_set_supply_hint(curve_data.snapshot.supply);
+	} else {
+		curve_reset();
+		/* The monitor stores the reset durations. */
+		if (!is_snapshot_reset()) {
+			curve_data.is_snapshot_dirty = true;
+		}
+	}
+
 	bcb_tc_def_msm_event(BCB_TC_DEF_EV_CMD_CLOSE, NULL);
 	k_delayed_work_submit(&curve_data.monitor_work, K_MSEC(MONITOR_WORK_INTERVAL));
 
@@ -230,6 +418,7 @@ static int trip_curve_open(void)
 		return -ENOTSUP;
 	}
 
+	curve_data.is_restoring = false;
 	bcb_tc_def_msm_event(BCB_TC_DEF_EV_CMD_OPEN, NULL);
 	k_delayed_work_cancel(&curve_data.monitor_work);
 
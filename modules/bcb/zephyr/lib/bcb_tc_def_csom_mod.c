@@ -6,7 +6,7 @@
 #include <string.h>
 
 // clang-format off
-#define CONFIG_OFFSET		CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_TC_DEF_CSOM_MOD
+#define CONFIG_VERSION		1
 #define LOG_LEVEL 		CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
 // clang-format on
 
@@ -26,12 +26,15 @@ struct tc_def_csom_data {
 
 struct tc_def_csom_data csom_data;
 
+BCB_CONFIG_ASSERT_SIZE(TC_DEF_CSOM_MOD, sizeof(bcb_tc_def_csom_mod_config_t));
+
 static int restore_config(void)
 {
 	int r;
 
-	r = bcb_config_load(CONFIG_OFFSET, (uint8_t *)&csom_data.config,
-			    sizeof(bcb_tc_def_csom_mod_config_t));
+	r = bcb_config_load(BCB_CONFIG_ID_TC_DEF_CSOM_MOD, CONFIG_VERSION,
+			    (uint8_t *)&csom_data.config, sizeof(bcb_tc_def_csom_mod_config_t),
+			    NULL);
 	if (r) {
 		LOG_ERR("cannot restore params: %d", r);
 	}
@@ -43,8 +46,8 @@ static int store_config(void)
 {
 	int r;
 
-	r = bcb_config_store(CONFIG_OFFSET, (uint8_t *)&csom_data.config,
-			     sizeof(bcb_tc_def_csom_mod_config_t));
+	r = bcb_config_store(BCB_CONFIG_ID_TC_DEF_CSOM_MOD, CONFIG_VERSION,
+			     (uint8_t *)&csom_data.config, sizeof(bcb_tc_def_csom_mod_config_t));
 	if (r) {
 		LOG_ERR("cannot store params: %d", r);
 	}
@@ -62,12 +65,9 @@ static void load_default_config(void)
 
 int bcb_tc_def_csom_mod_init(void)
 {
+	/* Defaults are kept for the fields an older stored config does not have. */
+	load_default_config();
 	if (restore_config()) {
-		/* Restoring could fail while trying to load old parameters. 
-		   So store default values into the config to avoid future errors.
-		   NOTE: This effectively overwrites the old parameters.
-		 */
-		load_default_config();
 		store_config();
 	}
 
@@ -108,7 +108,7 @@ static inline void csom_mod_on_zd_v_at_closed(void)
 {
 	csom_data.zdc++;
 	if (csom_data.zdc >= csom_data.config.zdc_closed) {
-		bcb_sw_off();
+		bcb_sw_off_at_zd(BCB_ZD_TYPE_VOLTAGE);
 	}
 	/* Stay in the same state */
 }
@@ -123,7 +123,7 @@ static inline void csom_mod_on_zd_v_at_opened(void)
 	csom_data.zdc++;
 	if (csom_data.zdc >= csom_data.config.zdc_period) {
 		csom_data.zdc = 0;
-		bcb_sw_on();
+		bcb_sw_on_at_zd(BCB_ZD_TYPE_VOLTAGE);
 	}
 	/* Stay in the same state */
 }
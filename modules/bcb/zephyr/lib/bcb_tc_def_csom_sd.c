@@ -0,0 +1,189 @@
+#include <lib/bcb_tc_def_csom_sd.h>
+#include <lib/bcb_tc_def_msm.h>
+#include <lib/bcb_sw.h>
+#include <lib/bcb_config.h>
+#include <logging/log.h>
+#include <string.h>
+
+// clang-format off
+#define CONFIG_VERSION		1
+#define LOG_LEVEL 		CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
+// clang-format on
+
+LOG_MODULE_REGISTER(bcb_tc_def_csom_sd);
+
+typedef enum {
+	TC_DEF_CSOM_SD_STATE_DISABLED = 0,
+	TC_DEF_CSOM_SD_STATE_ENABLED,
+} tc_def_csom_sd_state_t;
+
+struct tc_def_csom_sd_data {
+	bcb_tc_def_csom_sd_config_t config;
+	tc_def_csom_sd_state_t state;
+	uint32_t acc;
+	uint32_t zdc;
+};
+
+static struct tc_def_csom_sd_data csom_sd_data;
+
+BCB_CONFIG_ASSERT_SIZE(TC_DEF_CSOM_SD, sizeof(bcb_tc_def_csom_sd_config_t));
+
+static int restore_config(void)
+{
+	int r;
+
+	r = bcb_config_load(BCB_CONFIG_ID_TC_DEF_CSOM_SD, CONFIG_VERSION,
+			    (uint8_t *)&csom_sd_data.config, sizeof(bcb_tc_def_csom_sd_config_t),
+			    NULL);
+	if (r) {
+		LOG_ERR("cannot restore params: %d", r);
+	}
+
+	return r;
+}
+
+static int store_config(void)
+{
+	int r;
+
+	r = bcb_config_store(BCB_CONFIG_ID_TC_DEF_CSOM_SD, CONFIG_VERSION,
+			     (uint8_t *)&csom_sd_data.config, sizeof(bcb_tc_def_csom_sd_config_t));
+	if (r) {
+		LOG_ERR("cannot store params: %d", r);
+	}
+
+	return r;
+}
+
+static void load_default_config(void)
+{
+	LOG_INF("loading default config");
+
+	csom_sd_data.config.zdc_closed = 0;
+	csom_sd_data.config.zdc_period = 0;
+}
+
+static inline bool is_config_valid(bcb_tc_def_csom_sd_config_t *config)
+{
+	return config->zdc_closed && (config->zdc_closed < config->zdc_period);
+}
+
+int bcb_tc_def_csom_sd_init(void)
+{
+	/* Defaults are kept for the fields an older stored config does not have. */
+	load_default_config();
+	if (restore_config()) {
+		store_config();
+	}
+
+	csom_sd_data.state = TC_DEF_CSOM_SD_STATE_DISABLED;
+	csom_sd_data.acc = 0;
+	csom_sd_data.zdc = 0;
+
+	return 0;
+}
+
+int bcb_tc_def_csom_sd_config_set(bcb_tc_def_csom_sd_config_t *config)
+{
+	if (!config) {
+		return -EINVAL;
+	}
+
+	if (!is_config_valid(config)) {
+		LOG_ERR("invalid params");
+		return -EINVAL;
+	}
+
+	memcpy(&csom_sd_data.config, config, sizeof(bcb_tc_def_csom_sd_config_t));
+	/* Keep the accumulator within the new period so that the running pattern continues without
+	 * a burst of closed (or opened) half-cycles.
+	 */
+	csom_sd_data.acc %= csom_sd_data.config.zdc_period;
+
+	return store_config();
+}
+
+int bcb_tc_def_csom_sd_config_get(bcb_tc_def_csom_sd_config_t *config)
+{
+	if (!config) {
+		return -EINVAL;
+	}
+
+	memcpy(config, &csom_sd_data.config, sizeof(bcb_tc_def_csom_sd_config_t));
+
+	return 0;
+}
+
+static inline void csom_sd_on_zd_v_at_enabled(void)
+{
+	bool closed;
+
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT_CSOM_SD_FULL_CYCLE
+	/* Decide once per full cycle so that both polarities are always conducted equally. */
+	if (csom_sd_data.zdc++ & 1) {
+		return;
+	}
+#endif
+
+	csom_sd_data.acc += csom_sd_data.config.zdc_closed;
+	if (csom_sd_data.acc >= csom_sd_data.config.zdc_period) {
+		csom_sd_data.acc -= csom_sd_data.config.zdc_period;
+		closed = true;
+	} else {
+		closed = false;
+	}
+
+	/* The switch state is read back on every crossing instead of being tracked here. That way
+	 * a transition scheduled by the previously active operation mode is simply taken over.
+	 */
+	if (closed && !bcb_sw_is_on()) {
+		bcb_sw_on_at_zd(BCB_ZD_TYPE_VOLTAGE);
+	} else if (!closed && bcb_sw_is_on()) {
+		bcb_sw_off_at_zd(BCB_ZD_TYPE_VOLTAGE);
+	}
+	/* Stay in the same state */
+}
+
+static inline void csom_sd_at_disabled(void)
+{
+	if (!is_config_valid(&csom_sd_data.config)) {
+		return;
+	}
+
+	/* Start at the middle of the period to centre the closed half-cycles. */
+	csom_sd_data.acc = csom_sd_data.config.zdc_period / 2;
+	csom_sd_data.zdc = 0;
+	csom_sd_data.state = TC_DEF_CSOM_SD_STATE_ENABLED;
+}
+
+int bcb_tc_def_csom_sd_event(bcb_tc_def_event_t event, void *arg)
+{
+	if (csom_sd_data.state == TC_DEF_CSOM_SD_STATE_DISABLED) {
+		csom_sd_at_disabled();
+	}
+
+	switch (csom_sd_data.state) {
+	case TC_DEF_CSOM_SD_STATE_ENABLED: {
+		switch (event) {
+		case BCB_TC_DEF_EV_ZD_V: {
+			csom_sd_on_zd_v_at_enabled();
+		} break;
+		default: {
+			/* Other events are ignored */
+		} break;
+		}
+	} break;
+	default: {
+		/* Other events are ignored */
+	} break;
+	}
+
+	return 0;
+}
+
+void bcb_tc_def_csom_sd_cleanup(void)
+{
+	csom_sd_data.acc = 0;
+	csom_sd_data.zdc = 0;
+	csom_sd_data.state = TC_DEF_CSOM_SD_STATE_DISABLED;
+}
@@ -0,0 +1,107 @@
+#include <lib/bcb_tc_def_csom_ss.h>
+#include <lib/bcb_tc_def_msm.h>
+#include <lib/bcb_sw.h>
+#include <logging/log.h>
+
+// clang-format off
+#define SOFT_START_CYCLES	CONFIG_BCB_TRIP_CURVE_DEFAULT_SOFT_START_CYCLES
+#define LOG_LEVEL 		CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
+// clang-format on
+
+LOG_MODULE_REGISTER(bcb_tc_def_csom_ss);
+
+typedef enum {
+	TC_DEF_CSOM_SS_STATE_DISABLED = 0,
+	TC_DEF_CSOM_SS_STATE_RAMP,
+	TC_DEF_CSOM_SS_STATE_DONE,
+} tc_def_csom_ss_state_t;
+
+struct tc_def_csom_ss_data {
+	tc_def_csom_ss_state_t state;
+	uint16_t acc;
+	uint16_t zdc;
+};
+
+static struct tc_def_csom_ss_data csom_ss_data;
+
+int bcb_tc_def_csom_ss_init(void)
+{
+	bcb_tc_def_csom_ss_cleanup();
+
+	return 0;
+}
+
+static inline void csom_ss_on_zd_v_at_ramp(void)
+{
+	uint16_t step;
+	bool closed;
+
+	/* Only full cycles are skipped. Skipping single half-cycles would magnetise transformer
+	 * loads and make the inrush worse.
+	 */
+	if (csom_ss_data.zdc++ & 1) {
+		return;
+	}
+
+	step = (csom_ss_data.zdc >> 1) + 1;
+	if (step > SOFT_START_CYCLES) {
+		LOG_DBG("done");
+		csom_ss_data.state = TC_DEF_CSOM_SS_STATE_DONE;
+		return;
+	}
+
+	/* The duty cycle of the n-th cycle is n / SOFT_START_CYCLES. Conducting cycles are spread
+	 * using a first-order sigma-delta accumulator.
+	 */
+	csom_ss_data.acc += step;
+	if (csom_ss_data.acc >= SOFT_START_CYCLES) {
+		csom_ss_data.acc -= SOFT_START_CYCLES;
+		closed = true;
+	} else {
+		closed = false;
+	}
+
+	if (closed && !bcb_sw_is_on()) {
+		bcb_sw_on_at_zd(BCB_ZD_TYPE_VOLTAGE);
+	} else if (!closed && bcb_sw_is_on()) {
+		bcb_sw_off_at_zd(BCB_ZD_TYPE_VOLTAGE);
+	}
+	/* Stay in the same state */
+}
+
+int bcb_tc_def_csom_ss_event(bcb_tc_def_event_t event, void *arg)
+{
+	if (csom_ss_data.state == TC_DEF_CSOM_SS_STATE_DISABLED) {
+		csom_ss_data.state = TC_DEF_CSOM_SS_STATE_RAMP;
+	}
+
+	switch (csom_ss_data.state) {
+	case TC_DEF_CSOM_SS_STATE_RAMP: {
+		switch (event) {
+		case BCB_TC_DEF_EV_ZD_V: {
+			csom_ss_on_zd_v_at_ramp();
+		} break;
+		default: {
+			/* Other events are ignored */
+		} break;
+		}
+	} break;
+	default: {
+		/* Other events are ignored */
+	} break;
+	}
+
+	return 0;
+}
+
+bool bcb_tc_def_csom_ss_is_done(void)
+{
+	return csom_ss_data.state == TC_DEF_CSOM_SS_STATE_DONE;
+}
+
+void bcb_tc_def_csom_ss_cleanup(void)
+{
+	csom_ss_data.acc = 0;
+	csom_ss_data.zdc = 0;
+	csom_ss_data.state = TC_DEF_CSOM_SS_STATE_DISABLED;
+}
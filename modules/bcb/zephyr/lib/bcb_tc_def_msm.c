@@ -1,26 +1,38 @@
 #include <lib/bcb_tc_def_msm.h>
 #include <lib/bcb_tc_def_csom_mod.h>
+#include <lib/bcb_tc_def_csom_sd.h>
+#include <lib/bcb_tc_def_csom_ss.h>
+#include <lib/bcb_tc_def_rec.h>
+#include <lib/bcb_tc_def_ocpt.h>
 #include <lib/bcb_tc.h>
 #include <lib/bcb_config.h>
 #include <lib/bcb_sw.h>
 #include <lib/bcb_zd.h>
+#include <lib/bcb_timer.h>
 #include <logging/log.h>
 #include <init.h>
 #include <string.h>
 
 // clang-format off
-#define CONFIG_OFFSET                       CONFIG_BCB_LIB_PERSISTENT_CONFIG_OFFSET_TC_DEF_MSM
+#define CONFIG_VERSION                      1
 #define SUPPLY_WORK_TIMEOUT                 CONFIG_BCB_TRIP_CURVE_DEFAULT_SUPPLY_TIMER_TIMEOUT
+#define SUPPLY_FAST_TIMEOUT                 CONFIG_BCB_TRIP_CURVE_DEFAULT_SUPPLY_FAST_TIMEOUT
 #define RECOVERY_WORK_TIMEOUT               CONFIG_BCB_TRIP_CURVE_DEFAULT_RECOVERY_TIMER_TIMEOUT
 #define RECOVERY_RESET_WORK_TIMEOUT         CONFIG_BCB_TRIP_CURVE_DEFAULT_RECOVERY_RESET_TIMER_TIMEOUT
 #define RECOVERY_RESET_WORK_TIMEOUT_MAX     CONFIG_BCB_TRIP_CURVE_DEFAULT_RECOVERY_RESET_TIMER_TIMEOUT_MAX
 #define RECOVERY_RESET_WORK_TIMEOUT_MIN     CONFIG_BCB_TRIP_CURVE_DEFAULT_RECOVERY_RESET_TIMER_TIMEOUT_MIN
 #define ZD_COUNT_SUPPLY_WAIT                CONFIG_BCB_TRIP_CURVE_DEFAULT_SUPPLY_ZD_COUNT_MIN
+#define ZD_COUNT_SUPPLY_FAST                CONFIG_BCB_TRIP_CURVE_DEFAULT_SUPPLY_FAST_ZD_COUNT
+#define ZD_COUNT_OPEN_WAIT                  2
+#define SOFT_START_CYCLES                   CONFIG_BCB_TRIP_CURVE_DEFAULT_SOFT_START_CYCLES
 #define LOG_LEVEL                           CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
 // clang-format on
 
 LOG_MODULE_REGISTER(bcb_tc_def_msm);
 
+BUILD_ASSERT(SUPPLY_FAST_TIMEOUT < SUPPLY_WORK_TIMEOUT,
+	     "Fast supply detection must be shorter than the supply detection");
+
 #define MSM_EV_FILTER_ADD(var, ev)                                                                 \
 	do {                                                                                       \
 		(var) = ((var) | (1 << ev));                                                       \
@@ -40,17 +52,40 @@ struct tc_def_msm_data {
 	bcb_tc_def_msm_csom_t csom;
 	uint8_t zd_count;
 	bool is_ac_supply;
+	bool is_supply_known;
+	bcb_tc_def_msm_supply_t supply_hint; /* Expected by the next close command */
+	bcb_tc_def_msm_supply_t supply_wait; /* Expected by the ongoing supply detection */
 	uint32_t ev_filter;
 	uint16_t recovery_remaining;
+	bool is_rec_waiting;
 	struct k_work *notify_work;
-	struct k_delayed_work supply_detect_work;
-	struct k_delayed_work recovery_work;
-	struct k_delayed_work recovery_reset_work;
+	struct bcb_timer supply_detect_timer;
+	struct bcb_timer recovery_timer;
+	struct bcb_timer recovery_reset_timer;
 };
 
 static struct tc_def_msm_data msm_data;
 
 static inline void msm_csom_cleanup(void);
+static inline void msm_csom_soft_start(void);
+static inline bool msm_csom_is_soft_starting(void);
+static inline int msm_csom_ss(bcb_tc_def_event_t event, void *arg);
+
+static inline void msm_open_wait_enter(void)
+{
+	msm_data.state = BCB_TC_DEF_MSM_STATE_OPEN_WAIT;
+
+	if (!msm_data.is_ac_supply) {
+		bcb_sw_off();
+		return;
+	}
+
+	/* Open at the current zero-crossing. Voltage zero-crossings are used only if the
+	 * current is too low to be detected.
+	 */
+	msm_data.zd_count = 0;
+	bcb_zd_set_enable(BCB_ZD_TYPE_CURRENT, true);
+}
 
 static void set_cause_from_sw_cause(bcb_sw_cause_t sw_cause)
 {
@@ -70,37 +105,47 @@ static void set_cause_from_sw_cause(bcb_sw_cause_t sw_cause)
 static inline void msm_on_cmd_close_at_opened(void)
 {
 	LOG_INF("close");
-	k_delayed_work_cancel(&msm_data.supply_detect_work);
+	bcb_timer_stop(&msm_data.supply_detect_timer);
 	msm_data.zd_count = 0;
 	msm_data.state = BCB_TC_DEF_MSM_STATE_SUPPLY_WAIT;
+	msm_data.supply_wait = msm_data.supply_hint;
+	msm_data.supply_hint = BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
 	msm_data.cause = BCB_TC_DEF_MSM_CAUSE_EXT;
 	msm_data.csom = BCB_TC_DEF_MSM_CSOM_NONE;
 	msm_data.recovery_remaining = msm_data.config.rec_attempts;
+	msm_data.is_rec_waiting = false;
+	bcb_timer_stop(&msm_data.recovery_timer);
+	bcb_tc_def_rec_reset();
 	MSM_EV_FILTER_REM(msm_data.ev_filter, BCB_TC_DEF_EV_ZD_V);
-	k_delayed_work_submit(&msm_data.supply_detect_work, K_MSEC(SUPPLY_WORK_TIMEOUT));
+
+	if (msm_data.supply_wait == BCB_TC_DEF_MSM_SUPPLY_DC) {
+		/* No zero-crossing within a few half-periods confirms the DC supply. */
+		bcb_timer_start(&msm_data.supply_detect_timer,
+				(uint64_t)SUPPLY_FAST_TIMEOUT * 1000);
+	} else {
+		bcb_timer_start(&msm_data.supply_detect_timer,
+				(uint64_t)SUPPLY_WORK_TIMEOUT * 1000);
+	}
 }
 
 static inline void msm_on_cmd_open_at_supply_wait(void)
 {
 	LOG_INF("open");
-	k_delayed_work_cancel(&msm_data.supply_detect_work);
+	bcb_timer_stop(&msm_data.supply_detect_timer);
 	MSM_EV_FILTER_ADD(msm_data.ev_filter, BCB_TC_DEF_EV_ZD_V);
 	msm_data.state = BCB_TC_DEF_MSM_STATE_OPENED;
 	msm_data.cause = BCB_TC_DEF_MSM_CAUSE_EXT;
+	msm_data.supply_wait = BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
 }
 
-static inline void msm_on_zd_v_at_supply_wait(void)
-{
-	msm_data.zd_count++;
-}
-
-static inline void msm_on_supply_timer_at_supply_wait(void)
+static void msm_on_supply_detected(bool is_ac_supply)
 {
-	uint8_t zd_count = msm_data.zd_count;
 	msm_data.zd_count = 0;
 	msm_data.state = BCB_TC_DEF_MSM_STATE_CLOSE_WAIT;
+	msm_data.supply_wait = BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
+	msm_data.is_supply_known = true;
 
-	if (zd_count < ZD_COUNT_SUPPLY_WAIT) {
+	if (!is_ac_supply) {
 		/* We have a DC supply */
 		int r;
 
@@ -115,34 +160,84 @@ static inline void msm_on_supply_timer_at_supply_wait(void)
 	} else {
 		/* We have an AC supply */
 		msm_data.is_ac_supply = true;
+#ifdef CONFIG_BCB_TRIP_CURVE_DEFAULT_SOFT_START_ON_CLOSE
+		msm_csom_soft_start();
+#endif
 	}
 
 	LOG_INF("ac: %d", (uint8_t)msm_data.is_ac_supply);
 }
 
+static inline void msm_on_zd_v_at_supply_wait(void)
+{
+	msm_data.zd_count++;
+
+	if (msm_data.supply_wait == BCB_TC_DEF_MSM_SUPPLY_AC &&
+	    msm_data.zd_count >= ZD_COUNT_SUPPLY_FAST) {
+		bcb_timer_stop(&msm_data.supply_detect_timer);
+		msm_on_supply_detected(true);
+	}
+}
+
+static inline void msm_on_supply_timer_at_supply_wait(void)
+{
+	if (msm_data.supply_wait == BCB_TC_DEF_MSM_SUPPLY_DC && msm_data.zd_count) {
+		/* The supply has changed; fall back to the full detection time. */
+		msm_data.supply_wait = BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
+		bcb_timer_start(&msm_data.supply_detect_timer,
+				(uint64_t)(SUPPLY_WORK_TIMEOUT - SUPPLY_FAST_TIMEOUT) * 1000);
+		return;
+	}
+
+	msm_on_supply_detected(msm_data.zd_count >= ZD_COUNT_SUPPLY_WAIT);
+}
+
 static void msm_on_cmd_open_before_open_wait(void)
 {
 	LOG_INF("open");
 
 	if (!bcb_sw_is_on()) {
-		/* CSOM has already opened the switch. */
+		/* CSOM has already opened the switch or closing is still pending. */
+		bcb_sw_cancel_scheduled();
 		msm_data.state = BCB_TC_DEF_MSM_STATE_OPENED;
 		msm_data.cause = BCB_TC_DEF_MSM_CAUSE_EXT;
 		MSM_EV_FILTER_ADD(msm_data.ev_filter, BCB_TC_DEF_EV_ZD_V);
 		return;
 	}
 
-	msm_data.state = BCB_TC_DEF_MSM_STATE_OPEN_WAIT;
 	msm_data.cause = BCB_TC_DEF_MSM_CAUSE_EXT;
+	msm_open_wait_enter();
+}
 
-	if (!msm_data.is_ac_supply) {
-		bcb_sw_off();
+static inline void msm_on_zd_v_at_close_wait(void)
+{
+	if (msm_data.is_rec_waiting) {
+		/* Recovery back-off is still in progress. */
+		return;
+	}
+
+	if (msm_csom_is_soft_starting()) {
+		/* The ramp decides the first conducting cycle too, so the first close does not
+		 * carry the full inrush.
+		 */
+		msm_csom_ss(BCB_TC_DEF_EV_ZD_V, NULL);
+		return;
+	}
+
+	if (bcb_sw_on_at_zd(BCB_ZD_TYPE_VOLTAGE)) {
+		set_cause_from_sw_cause(bcb_sw_get_cause());
 	}
 }
 
-static inline void msm_on_zd_v_rec_timer_at_close_wait(void)
+static inline void msm_on_rec_timer_at_close_wait(void)
 {
-	k_delayed_work_cancel(&msm_data.recovery_work);
+	bcb_timer_stop(&msm_data.recovery_timer);
+
+	if (msm_data.is_ac_supply) {
+		/* Close at the next zero-crossing. */
+		msm_data.is_rec_waiting = false;
+		return;
+	}
 
 	if (bcb_sw_on()) {
 		set_cause_from_sw_cause(bcb_sw_get_cause());
@@ -152,32 +247,39 @@ static inline void msm_on_zd_v_rec_timer_at_close_wait(void)
 static inline void msm_on_sw_closed_at_close_wait(void)
 {
 	msm_data.state = BCB_TC_DEF_MSM_STATE_CLOSED;
+	bcb_tc_def_rec_on_close();
 	if (msm_data.recovery_remaining < msm_data.config.rec_attempts) {
-		k_delayed_work_submit(&msm_data.recovery_reset_work,
-				      K_MSEC(msm_data.config.rec_reset_timeout));
+		bcb_timer_start(&msm_data.recovery_reset_timer,
+				(uint64_t)msm_data.config.rec_reset_timeout * 1000);
 	}
 }
 
 static inline void msm_on_ocd_at_closed(void)
 {
-	msm_data.state = BCB_TC_DEF_MSM_STATE_OPEN_WAIT;
 	msm_data.cause = BCB_TC_DEF_MSM_CAUSE_OCD;
-
-	if (!msm_data.is_ac_supply) {
-		bcb_sw_off();
-	}
+	msm_open_wait_enter();
 }
 
 static inline void msm_on_sw_opened_at_closed(void)
 {
-	k_delayed_work_cancel(&msm_data.recovery_reset_work);
-
+	uint32_t delay;
 	bcb_sw_cause_t sw_cause = bcb_sw_get_cause();
 	if (sw_cause == BCB_SW_CAUSE_EXT) {
 		/* Opened by CSOM */
 		return;
 	}
 
+	if (sw_cause == BCB_SW_CAUSE_OCP_TEST && bcb_tc_def_ocpt_is_running()) {
+		/* Scheduled self-test. Re-close without reporting a trip. */
+		msm_data.state = BCB_TC_DEF_MSM_STATE_CLOSE_WAIT;
+		if (!msm_data.is_ac_supply && bcb_sw_on()) {
+			set_cause_from_sw_cause(bcb_sw_get_cause());
+		}
+		return;
+	}
+
+	bcb_timer_stop(&msm_data.recovery_reset_timer);
+
 	if (sw_cause != BCB_SW_CAUSE_OCP) {
 		MSM_EV_FILTER_ADD(msm_data.ev_filter, BCB_TC_DEF_EV_ZD_V);
 		msm_data.state = BCB_TC_DEF_MSM_STATE_OPENED;
@@ -186,7 +288,11 @@ static inline void msm_on_sw_opened_at_closed(void)
 		return;
 	}
 
-	if (!msm_data.recovery_remaining) {
+	bcb_tc_def_rec_on_trip(bcb_sw_get_on_off_duration());
+
+	if (!msm_data.recovery_remaining ||
+	    bcb_tc_def_rec_next(&msm_data.config,
+				msm_data.config.rec_attempts - msm_data.recovery_remaining, &delay)) {
 		MSM_EV_FILTER_ADD(msm_data.ev_filter, BCB_TC_DEF_EV_ZD_V);
 		msm_data.state = BCB_TC_DEF_MSM_STATE_OPENED;
 		set_cause_from_sw_cause(sw_cause);
@@ -196,36 +302,90 @@ static inline void msm_on_sw_opened_at_closed(void)
 
 	msm_data.recovery_remaining--;
 	msm_data.state = BCB_TC_DEF_MSM_STATE_CLOSE_WAIT;
+	/* Limit the inrush of the load so that the recovery is not spent on it. */
+	msm_csom_soft_start();
 
 	if (!msm_data.is_ac_supply) {
-		k_delayed_work_submit(&msm_data.recovery_work, K_USEC(msm_data.config.rec_delay));
+		bcb_timer_start(&msm_data.recovery_timer, delay);
+	} else if (msm_data.config.rec_policy == BCB_TC_DEF_MSM_REC_POLICY_BACKOFF) {
+		/* Close at the first zero-crossing after the back-off delay. */
+		msm_data.is_rec_waiting = true;
+		bcb_timer_start(&msm_data.recovery_timer, delay);
 	}
 }
 
 static inline void msm_on_zd_v_at_open_wait(void)
 {
-	bcb_sw_off();
+	if (++msm_data.zd_count > ZD_COUNT_OPEN_WAIT) {
+		/* No current zero-crossing within a full cycle. */
+		bcb_sw_off_at_zd(BCB_ZD_TYPE_VOLTAGE);
+	}
+}
+
+static inline void msm_on_zd_i_at_open_wait(void)
+{
+	bcb_sw_off_at_zd(BCB_ZD_TYPE_CURRENT);
 }
 
 static inline void msm_on_sw_opened_at_open_wait(void)
 {
+	bcb_zd_set_enable(BCB_ZD_TYPE_CURRENT, false);
 	msm_data.state = BCB_TC_DEF_MSM_STATE_OPENED;
 	MSM_EV_FILTER_ADD(msm_data.ev_filter, BCB_TC_DEF_EV_ZD_V);
 }
 
-static inline void msm_csom_cleanup(void)
+static inline void msm_csom_reset(bcb_tc_def_msm_csom_t csom)
 {
-	switch (msm_data.csom) {
+	switch (csom) {
 	case BCB_TC_DEF_MSM_CSOM_MOD: {
 		bcb_tc_def_csom_mod_cleanup();
 	} break;
+	case BCB_TC_DEF_MSM_CSOM_SD: {
+		bcb_tc_def_csom_sd_cleanup();
+	} break;
+	case BCB_TC_DEF_MSM_CSOM_SS: {
+		bcb_tc_def_csom_ss_cleanup();
+	} break;
 	default: {
 	} break;
 	}
+}
+
+static inline void msm_csom_soft_start(void)
+{
+	if (!SOFT_START_CYCLES || !msm_data.is_ac_supply) {
+		return;
+	}
+
+	/* Soft-start runs before the configured CSOM. It is replaced by the configured one
+	 * through the usual CSOM change once the ramp has been completed.
+	 */
+	msm_csom_reset(msm_data.csom);
+	msm_data.csom = BCB_TC_DEF_MSM_CSOM_SS;
+	msm_csom_reset(msm_data.csom);
+}
+
+static inline bool msm_csom_is_soft_starting(void)
+{
+	return msm_data.csom == BCB_TC_DEF_MSM_CSOM_SS && !bcb_tc_def_csom_ss_is_done();
+}
+
+static inline void msm_csom_cleanup(void)
+{
+	msm_csom_reset(msm_data.csom);
+	msm_data.csom = msm_data.config.csom;
+	msm_csom_reset(msm_data.csom);
 
 	if (bcb_sw_is_on()) {
 		return;
 	}
+
+	if (msm_data.is_ac_supply && msm_data.csom == BCB_TC_DEF_MSM_CSOM_SD) {
+		/* Sigma-delta modulation reads back the switch state on every zero-crossing.
+		 * So it takes over an opened switch (or a pending transition) without re-closing.
+		 */
+		return;
+	}
 	/* Need to re-close the switch since we are still in the closed state. */
 	msm_data.state = BCB_TC_DEF_MSM_STATE_CLOSE_WAIT;
 
@@ -250,6 +410,26 @@ static inline int msm_csom_mod(bcb_tc_def_event_t event, void *arg)
 	return bcb_tc_def_csom_mod_event(event, arg);
 }
 
+static inline int msm_csom_sd(bcb_tc_def_event_t event, void *arg)
+{
+	if (!msm_data.is_ac_supply) {
+		/* Modulation control is applicable only to AC supplies. */
+		return -ENOTSUP;
+	}
+
+	return bcb_tc_def_csom_sd_event(event, arg);
+}
+
+static inline int msm_csom_ss(bcb_tc_def_event_t event, void *arg)
+{
+	if (!msm_data.is_ac_supply) {
+		/* Soft-start is applicable only to AC supplies. */
+		return -ENOTSUP;
+	}
+
+	return bcb_tc_def_csom_ss_event(event, arg);
+}
+
 static inline int msm_csom_event(bcb_tc_def_event_t event, void *arg)
 {
 	int r = 0;
@@ -258,9 +438,8 @@ static inline int msm_csom_event(bcb_tc_def_event_t event, void *arg)
 		return 0;
 	}
 
-	if (msm_data.csom != msm_data.config.csom) {
+	if (msm_data.csom != msm_data.config.csom && !msm_csom_is_soft_starting()) {
 		/* CSOM has been changed. Cleanup and re-close the switch if needed. */
-		msm_data.csom = msm_data.config.csom;
 		msm_csom_cleanup();
 		return 0;
 	}
@@ -269,6 +448,12 @@ static inline int msm_csom_event(bcb_tc_def_event_t event, void *arg)
 	case BCB_TC_DEF_MSM_CSOM_MOD: {
 		r = msm_csom_mod(event, arg);
 	} break;
+	case BCB_TC_DEF_MSM_CSOM_SD: {
+		r = msm_csom_sd(event, arg);
+	} break;
+	case BCB_TC_DEF_MSM_CSOM_SS: {
+		r = msm_csom_ss(event, arg);
+	} break;
 	default: {
 	} break;
 	}
@@ -276,12 +461,14 @@ static inline int msm_csom_event(bcb_tc_def_event_t event, void *arg)
 	return r;
 }
 
+BCB_CONFIG_ASSERT_SIZE(TC_DEF_MSM, sizeof(bcb_tc_def_msm_config_t));
+
 static int restore_config(void)
 {
 	int r;
 
-	r = bcb_config_load(CONFIG_OFFSET, (uint8_t *)&msm_data.config,
-			    sizeof(bcb_tc_def_msm_config_t));
+	r = bcb_config_load(BCB_CONFIG_ID_TC_DEF_MSM, CONFIG_VERSION,
+			    (uint8_t *)&msm_data.config, sizeof(bcb_tc_def_msm_config_t), NULL);
 	if (r) {
 		LOG_ERR("cannot restore params: %d", r);
 	}
@@ -293,8 +480,8 @@ static int store_config(void)
 {
 	int r;
 
-	r = bcb_config_store(CONFIG_OFFSET, (uint8_t *)&msm_data.config,
-			     sizeof(bcb_tc_def_msm_config_t));
+	r = bcb_config_store(BCB_CONFIG_ID_TC_DEF_MSM, CONFIG_VERSION,
+			     (uint8_t *)&msm_data.config, sizeof(bcb_tc_def_msm_config_t));
 	if (r) {
 		LOG_ERR("cannot store params: %d", r);
 	}
@@ -311,6 +498,7 @@ static void load_default_config(void)
 	msm_data.config.rec_attempts = 0;
 	msm_data.config.rec_delay = 1000 * RECOVERY_WORK_TIMEOUT;
 	msm_data.config.rec_reset_timeout = RECOVERY_RESET_WORK_TIMEOUT;
+	msm_data.config.rec_policy = BCB_TC_DEF_MSM_REC_POLICY_FIXED;
 }
 
 int bcb_tc_def_msm_init(struct k_work *notify_work)
@@ -321,12 +509,9 @@ int bcb_tc_def_msm_init(struct k_work *notify_work)
 
 	msm_data.notify_work = notify_work;
 
+	/* Defaults are kept for the fields an older stored config does not have. */
+	load_default_config();
 	if (restore_config()) {
-		/* Restoring could fail while trying to load old parameters. 
-		   So store default values into the config to avoid future errors.
-		   NOTE: This effectively overwrites the old parameters.
-		 */
-		load_default_config();
 		store_config();
 	}
 
@@ -340,6 +525,10 @@ int bcb_tc_def_msm_init(struct k_work *notify_work)
 	msm_data.zd_count = 0;
 
 	bcb_tc_def_csom_mod_init();
+	bcb_tc_def_csom_sd_init();
+	bcb_tc_def_csom_ss_init();
+	bcb_tc_def_rec_init();
+	bcb_tc_def_ocpt_init();
 	return 0;
 }
 
@@ -386,9 +575,11 @@ int bcb_tc_def_msm_event(bcb_tc_def_event_t event, void *arg)
 		case BCB_TC_DEF_EV_CMD_OPEN: {
 			msm_on_cmd_open_before_open_wait();
 		} break;
-		case BCB_TC_DEF_EV_REC_TIMER:
+		case BCB_TC_DEF_EV_REC_TIMER: {
+			msm_on_rec_timer_at_close_wait();
+		} break;
 		case BCB_TC_DEF_EV_ZD_V: {
-			msm_on_zd_v_rec_timer_at_close_wait();
+			msm_on_zd_v_at_close_wait();
 		} break;
 		case BCB_TC_DEF_EV_SW_CLOSED: {
 			msm_on_sw_closed_at_close_wait();
@@ -412,6 +603,7 @@ int bcb_tc_def_msm_event(bcb_tc_def_event_t event, void *arg)
 
 		case BCB_TC_DEF_EV_REC_RESET_TIMER: {
 			msm_data.recovery_remaining = msm_data.config.rec_attempts;
+			bcb_tc_def_rec_reset();
 			LOG_INF("Reset recovery attempts: %d", msm_data.recovery_remaining);
 		} break;
 		default: {
@@ -425,6 +617,9 @@ int bcb_tc_def_msm_event(bcb_tc_def_event_t event, void *arg)
 		case BCB_TC_DEF_EV_ZD_V: {
 			msm_on_zd_v_at_open_wait();
 		} break;
+		case BCB_TC_DEF_EV_ZD_I: {
+			msm_on_zd_i_at_open_wait();
+		} break;
 		case BCB_TC_DEF_EV_SW_OPENED: {
 			msm_on_sw_opened_at_open_wait();
 		} break;
@@ -447,11 +642,16 @@ int bcb_tc_def_msm_config_set(bcb_tc_def_msm_config_t *config)
 		return -EINVAL;
 	}
 
-	if (config->csom >= BCB_TC_DEF_MSM_CSOM_END) {
+	if (config->csom >= BCB_TC_DEF_MSM_CSOM_END || config->csom == BCB_TC_DEF_MSM_CSOM_SS) {
 		LOG_ERR("invalid csom: %d", config->csom);
 		return -EINVAL;
 	}
 
+	if (config->rec_policy >= BCB_TC_DEF_MSM_REC_POLICY_END) {
+		LOG_ERR("invalid recovery policy: %d", config->rec_policy);
+		return -EINVAL;
+	}
+
 	if (config->rec_reset_timeout < RECOVERY_RESET_WORK_TIMEOUT_MIN ||
 	    config->rec_reset_timeout > RECOVERY_RESET_WORK_TIMEOUT_MAX) {
 		return -EINVAL;
@@ -484,17 +684,35 @@ bcb_tc_def_msm_cause_t bcb_tc_def_msm_get_cause(void)
 	return msm_data.cause;
 }
 
-static void on_supply_detect_work(struct k_work *work)
+void bcb_tc_def_msm_set_supply_hint(bcb_tc_def_msm_supply_t supply)
+{
+	if (supply >= BCB_TC_DEF_MSM_SUPPLY_END) {
+		supply = BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
+	}
+
+	msm_data.supply_hint = supply;
+}
+
+bcb_tc_def_msm_supply_t bcb_tc_def_msm_get_supply(void)
+{
+	if (!msm_data.is_supply_known) {
+		return BCB_TC_DEF_MSM_SUPPLY_UNKNOWN;
+	}
+
+	return msm_data.is_ac_supply ? BCB_TC_DEF_MSM_SUPPLY_AC : BCB_TC_DEF_MSM_SUPPLY_DC;
+}
+
+static void on_supply_detect_timer(struct bcb_timer *timer)
 {
 	bcb_tc_def_msm_event(BCB_TC_DEF_EV_SUPPLY_TIMER, NULL);
 }
 
-static void on_recovery_work(struct k_work *work)
+static void on_recovery_timer(struct bcb_timer *timer)
 {
 	bcb_tc_def_msm_event(BCB_TC_DEF_EV_REC_TIMER, NULL);
 }
 
-static void on_recovery_reset_work(struct k_work *work)
+static void on_recovery_reset_timer(struct bcb_timer *timer)
 {
 	bcb_tc_def_msm_event(BCB_TC_DEF_EV_REC_RESET_TIMER, NULL);
 }
@@ -502,9 +720,10 @@ static void on_recovery_reset_work(struct k_work *work)
 static int tc_def_msm_system_init()
 {
 	memset(&msm_data, 0, sizeof(msm_data));
-	k_delayed_work_init(&msm_data.supply_detect_work, on_supply_detect_work);
-	k_delayed_work_init(&msm_data.recovery_work, on_recovery_work);
-	k_delayed_work_init(&msm_data.recovery_reset_work, on_recovery_reset_work);
+	/* MSM events are processed in the system workqueue. */
+	bcb_timer_setup(&msm_data.supply_detect_timer, on_supply_detect_timer, true);
+	bcb_timer_setup(&msm_data.recovery_timer, on_recovery_timer, true);
+	bcb_timer_setup(&msm_data.recovery_reset_timer, on_recovery_reset_timer, true);
 	return 0;
 }
 
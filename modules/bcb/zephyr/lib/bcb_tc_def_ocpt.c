@@ -0,0 +1,434 @@
+#include <lib/bcb_tc_def_ocpt.h>
+#include <lib/bcb_tc_def_msm.h>
+#include <lib/bcb_config.h>
+#include <lib/bcb_journal.h>
+#include <lib/bcb_msmnt.h>
+#include <lib/bcb_sw.h>
+#include <lib/bcb_zd.h>
+#include <logging/log.h>
+#include <zephyr.h>
+#include <string.h>
+
+// clang-format off
+#define RECORD_VERSION          1
+#define INTERVAL                CONFIG_BCB_TRIP_CURVE_DEFAULT_OCPT_INTERVAL
+#define MAX_CURRENT             CONFIG_BCB_TRIP_CURVE_DEFAULT_OCPT_MAX_CURRENT
+#define MAX_DURATION            ((uint32_t)CONFIG_BCB_TRIP_CURVE_DEFAULT_OCPT_MAX_DURATION * 1000U)
+#define LOG_SIZE                CONFIG_BCB_TRIP_CURVE_DEFAULT_OCPT_LOG_SIZE
+#define CHECK_INTERVAL          10000
+#define ZD_TIMEOUT              100
+#define TRIGGER_TIMEOUT         100
+#define RECLOSE_TIMEOUT         1000
+#define SETTLE_TIME             1000
+#define ENTRY_FLAG_NEGATIVE     (1U << 0)
+#define ENTRY_FLAG_PASSED       (1U << 1)
+#define LOG_LEVEL               CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
+// clang-format on
+
+LOG_MODULE_REGISTER(bcb_tc_def_ocpt);
+
+typedef enum {
+	OCPT_STATE_IDLE = 0,
+	OCPT_STATE_WAIT, /* Waiting for a low-load instant. */
+	OCPT_STATE_ARMED, /* Waiting for a voltage zero-crossing. */
+	OCPT_STATE_TRIGGERED, /* Waiting for the switch to open. */
+	OCPT_STATE_RECLOSE, /* Waiting for the main state machine to re-close the switch. */
+} ocpt_state_t;
+
+struct __attribute__((packed)) ocpt_entry {
+	uint16_t seq;
+	uint8_t flags;
+	uint32_t duration;
+};
+
+struct __attribute__((packed)) ocpt_record {
+	uint16_t interval;
+	uint16_t seq;
+	uint8_t head;
+	uint8_t count;
+	struct ocpt_entry entries[LOG_SIZE];
+};
+
+BCB_CONFIG_LOG_ASSERT_SIZE(TC_DEF_OCPT, sizeof(struct ocpt_record));
+
+struct tc_def_ocpt_data {
+	volatile ocpt_state_t state;
+	bcb_ocp_direction_t direction;
+	struct ocpt_record record;
+	int64_t next_time;
+	struct k_delayed_work work;
+	struct bcb_zd_callback zd_callback;
+	struct bcb_sw_callback sw_callback;
+};
+
+static struct tc_def_ocpt_data ocpt_data;
+
+static int restore_record(void)
+{
+	int r;
+
+	r = bcb_config_log_load(BCB_CONFIG_LOG_ID_TC_DEF_OCPT, RECORD_VERSION,
+				(uint8_t *)&ocpt_data.record, sizeof(ocpt_data.record), NULL);
+	if (r) {
+		LOG_ERR("cannot restore log: %d", r);
+		return r;
+	}
+
+	if (ocpt_data.record.head >= LOG_SIZE || ocpt_data.record.count > LOG_SIZE) {
+		LOG_ERR("invalid log");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int store_record(void)
+{
+	int r;
+
+	r = bcb_config_log_store(BCB_CONFIG_LOG_ID_TC_DEF_OCPT, RECORD_VERSION,
+				 (uint8_t *)&ocpt_data.record, sizeof(ocpt_data.record));
+	if (r) {
+		LOG_ERR("cannot store log: %d", r);
+	}
+
+	return r;
+}
+
+static void load_default_record(void)
+{
+	LOG_INF("loading default log");
+
+	memset(&ocpt_data.record, 0, sizeof(ocpt_data.record));
+	ocpt_data.record.interval = INTERVAL;
+}
+
+static inline void entry_to_result(const struct ocpt_entry *entry,
+				   bcb_tc_def_ocpt_result_t *result)
+{
+	result->seq = entry->seq;
+	result->direction = entry->flags & ENTRY_FLAG_NEGATIVE ? BCB_OCP_DIRECTION_NEGATIVE :
+								 BCB_OCP_DIRECTION_POSITIVE;
+	result->passed = (entry->flags & ENTRY_FLAG_PASSED) != 0;
+	result->duration = entry->duration;
+}
+
+static void result_add(bool passed, uint32_t duration)
+{
+	struct ocpt_entry *entry;
+
+	ocpt_data.record.head = (ocpt_data.record.head + 1) % LOG_SIZE;
+	if (ocpt_data.record.count < LOG_SIZE) {
+		ocpt_data.record.count++;
+	}
+
+	entry = &ocpt_data.record.entries[ocpt_data.record.head];
+	entry->seq = ocpt_data.record.seq;
+	entry->flags = 0;
+	entry->duration = duration;
+
+	if (ocpt_data.direction == BCB_OCP_DIRECTION_NEGATIVE) {
+		entry->flags |= ENTRY_FLAG_NEGATIVE;
+	}
+
+	if (passed) {
+		entry->flags |= ENTRY_FLAG_PASSED;
+		LOG_INF("passed: direction %" PRIu8 ", duration %" PRIu32 " ns",
+			(uint8_t)ocpt_data.direction, duration);
+	} else {
+		LOG_WRN("failed: direction %" PRIu8 ", duration %" PRIu32 " ns",
+			(uint8_t)ocpt_data.direction, duration);
+	}
+
+	bcb_journal_add(BCB_JOURNAL_TYPE_OCP_TEST,
+			(uint8_t)ocpt_data.direction | (passed ? BCB_JOURNAL_ARG_PASSED : 0),
+			(int32_t)duration);
+
+	store_record();
+}
+
+static bool is_low_load(void)
+{
+	bcb_tc_def_msm_config_t config;
+
+	if (bcb_tc_def_msm_get_state() != BCB_TC_DEF_MSM_STATE_CLOSED || !bcb_sw_is_on()) {
+		return false;
+	}
+
+	/* Closed-state operation modes switch on their own. */
+	bcb_tc_def_msm_config_get(&config);
+	if (config.csom != BCB_TC_DEF_MSM_CSOM_NONE) {
+		return false;
+	}
+
+	return bcb_msmnt_get_current_rms() <= MAX_CURRENT;
+}
+
+/* Can be called from an ISR. */
+static void ocpt_trigger(void)
+{
+	if (bcb_ocp_test_trigger(ocpt_data.direction, true)) {
+		ocpt_data.state = OCPT_STATE_WAIT;
+		k_delayed_work_submit(&ocpt_data.work, K_MSEC(CHECK_INTERVAL));
+		return;
+	}
+
+	ocpt_data.state = OCPT_STATE_TRIGGERED;
+	k_delayed_work_submit(&ocpt_data.work, K_MSEC(TRIGGER_TIMEOUT));
+}
+
+static void ocpt_stop(void)
+{
+	ocpt_data.state = OCPT_STATE_IDLE;
+	ocpt_data.next_time = k_uptime_get() + (int64_t)ocpt_data.record.interval * 3600000;
+	k_delayed_work_submit(&ocpt_data.work, K_MSEC(CHECK_INTERVAL));
+}
+
+static void ocpt_next(void)
+{
+	if (ocpt_data.direction == BCB_OCP_DIRECTION_POSITIVE) {
+		ocpt_data.direction = BCB_OCP_DIRECTION_NEGATIVE;
+		ocpt_data.state = OCPT_STATE_WAIT;
+		k_delayed_work_submit(&ocpt_data.work, K_MSEC(SETTLE_TIME));
+		return;
+	}
+
+	ocpt_stop();
+}
+
+static void ocpt_start(void)
+{
+	ocpt_data.record.seq++;
+	ocpt_data.direction = BCB_OCP_DIRECTION_POSITIVE;
+	ocpt_data.state = OCPT_STATE_WAIT;
+}
+
+static void on_ocpt_work(struct k_work *work)
+{
+	unsigned int key;
+
+	switch (ocpt_data.state) {
+	case OCPT_STATE_IDLE: {
+		if (!ocpt_data.record.interval || k_uptime_get() < ocpt_data.next_time) {
+			k_delayed_work_submit(&ocpt_data.work, K_MSEC(CHECK_INTERVAL));
+			return;
+		}
+
+		ocpt_start();
+	} break;
+	case OCPT_STATE_ARMED: {
+		key = irq_lock();
+		if (ocpt_data.state == OCPT_STATE_ARMED) {
+			/* No voltage zero-crossings (DC supply). */
+			ocpt_trigger();
+		}
+		irq_unlock(key);
+		return;
+	}
+	case OCPT_STATE_TRIGGERED: {
+		bcb_ocp_test_trigger(ocpt_data.direction, false);
+		result_add(false, UINT32_MAX);
+		ocpt_next();
+		return;
+	}
+	case OCPT_STATE_RECLOSE: {
+		LOG_WRN("switch not re-closed, aborting");
+		ocpt_stop();
+		return;
+	}
+	default: {
+	} break;
+	}
+
+	/* OCPT_STATE_WAIT */
+	if (!is_low_load()) {
+		k_delayed_work_submit(&ocpt_data.work, K_MSEC(CHECK_INTERVAL));
+		return;
+	}
+
+	ocpt_data.state = OCPT_STATE_ARMED;
+	k_delayed_work_submit(&ocpt_data.work, K_MSEC(ZD_TIMEOUT));
+}
+
+static void on_zd_voltage(void)
+{
+	if (ocpt_data.state != OCPT_STATE_ARMED) {
+		return;
+	}
+
+	ocpt_trigger();
+}
+
+static void on_switch_changed(bool is_closed, bcb_sw_cause_t cause)
+{
+	uint32_t duration;
+
+	if (is_closed) {
+		if (ocpt_data.state == OCPT_STATE_RECLOSE) {
+			ocpt_next();
+		}
+		return;
+	}
+
+	if (ocpt_data.state != OCPT_STATE_TRIGGERED) {
+		return;
+	}
+
+	if (cause != BCB_SW_CAUSE_OCP_TEST) {
+		LOG_WRN("opened by cause %" PRIu8 ", aborting", (uint8_t)cause);
+		bcb_ocp_test_trigger(ocpt_data.direction, false);
+		ocpt_stop();
+		return;
+	}
+
+	duration = bcb_ocp_test_get_duration();
+	result_add(duration <= MAX_DURATION, duration);
+
+	ocpt_data.state = OCPT_STATE_RECLOSE;
+	k_delayed_work_submit(&ocpt_data.work, K_MSEC(RECLOSE_TIMEOUT));
+}
+
+int bcb_tc_def_ocpt_init(void)
+{
+	if (restore_record()) {
+		load_default_record();
+		store_record();
+	}
+
+	ocpt_data.state = OCPT_STATE_IDLE;
+	ocpt_data.next_time = (int64_t)ocpt_data.record.interval * 3600000;
+
+	k_delayed_work_init(&ocpt_data.work, on_ocpt_work);
+	ocpt_data.zd_callback.handler = on_zd_voltage;
+	ocpt_data.sw_callback.handler = on_switch_changed;
+	bcb_zd_add_callback(BCB_ZD_TYPE_VOLTAGE, &ocpt_data.zd_callback);
+	bcb_sw_add_callback(&ocpt_data.sw_callback);
+
+	k_delayed_work_submit(&ocpt_data.work, K_MSEC(CHECK_INTERVAL));
+
+	return 0;
+}
+
+int bcb_tc_def_ocpt_shutdown(void)
+{
+	k_delayed_work_cancel(&ocpt_data.work);
+	bcb_zd_remove_callback(BCB_ZD_TYPE_VOLTAGE, &ocpt_data.zd_callback);
+	bcb_sw_remove_callback(&ocpt_data.sw_callback);
+
+	if (ocpt_data.state == OCPT_STATE_TRIGGERED) {
+		bcb_ocp_test_trigger(ocpt_data.direction, false);
+	}
+
+	ocpt_data.state = OCPT_STATE_IDLE;
+
+	return 0;
+}
+
+bool bcb_tc_def_ocpt_is_running(void)
+{
+	return ocpt_data.state == OCPT_STATE_TRIGGERED || ocpt_data.state == OCPT_STATE_RECLOSE;
+}
+
+int bcb_tc_def_ocpt_run(void)
+{
+	if (ocpt_data.state != OCPT_STATE_IDLE) {
+		return -EBUSY;
+	}
+
+	ocpt_start();
+	k_delayed_work_submit(&ocpt_data.work, K_NO_WAIT);
+
+	return 0;
+}
+
+int bcb_tc_def_ocpt_set_interval(uint16_t interval)
+{
+	ocpt_data.record.interval = interval;
+	ocpt_data.next_time = k_uptime_get() + (int64_t)interval * 3600000;
+
+	return store_record();
+}
+
+uint16_t bcb_tc_def_ocpt_get_interval(void)
+{
+	return ocpt_data.record.interval;
+}
+
+int bcb_tc_def_ocpt_get_result(uint8_t index, bcb_tc_def_ocpt_result_t *result)
+{
+	if (index >= ocpt_data.record.count) {
+		return -ENOENT;
+	}
+
+	entry_to_result(
+		&ocpt_data.record.entries[(ocpt_data.record.head + LOG_SIZE - index) % LOG_SIZE],
+		result);
+
+	return 0;
+}
+
+int bcb_tc_def_ocpt_get_trend(bcb_ocp_direction_t direction, bcb_tc_def_ocpt_trend_t *trend)
+{
+	bcb_tc_def_ocpt_result_t result;
+	uint64_t sum = 0;
+	uint64_t sum_old = 0;
+	uint32_t passed = 0;
+	uint32_t passed_old;
+	uint8_t i;
+
+	if (!trend) {
+		return -EINVAL;
+	}
+
+	memset(trend, 0, sizeof(bcb_tc_def_ocpt_trend_t));
+
+	for (i = 0; !bcb_tc_def_ocpt_get_result(i, &result); i++) {
+		if (result.direction != direction) {
+			continue;
+		}
+
+		trend->count++;
+		if (!result.passed) {
+			trend->failures++;
+			continue;
+		}
+
+		if (!passed || result.duration < trend->min) {
+			trend->min = result.duration;
+		}
+
+		if (result.duration > trend->max) {
+			trend->max = result.duration;
+		}
+
+		passed++;
+		sum += result.duration;
+	}
+
+	if (!passed) {
+		return 0;
+	}
+
+	trend->mean = (uint32_t)(sum / passed);
+
+	if (passed < 2) {
+		return 0;
+	}
+
+	/* Results are iterated from the latest. So the older half comes last. */
+	passed_old = 0;
+	for (i = ocpt_data.record.count; i > 0 && passed_old < passed / 2; i--) {
+		bcb_tc_def_ocpt_get_result(i - 1, &result);
+		if (result.direction != direction || !result.passed) {
+			continue;
+		}
+
+		passed_old++;
+		sum_old += result.duration;
+	}
+
+	trend->drift = (int32_t)((int64_t)((sum - sum_old) / (passed - passed_old)) -
+				 (int64_t)(sum_old / passed_old));
+
+	return 0;
+}
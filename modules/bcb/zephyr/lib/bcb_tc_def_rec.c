@@ -0,0 +1,309 @@
+#include <lib/bcb_tc_def_rec.h>
+#include <lib/bcb_tc_def_msm.h>
+#include <lib/bcb_msmnt.h>
+#include <lib/bcb_etime.h>
+#include <logging/log.h>
+#include <random/rand32.h>
+#include <zephyr.h>
+#include <string.h>
+
+// clang-format off
+#define BACKOFF_MAX             ((uint64_t)CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_BACKOFF_MAX * 1000U)
+#define BACKOFF_JITTER          CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_BACKOFF_JITTER
+#define BUDGET                  CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_BUDGET
+#define BUDGET_PERIOD           (3600U * 1000U)
+#define HARD_SHORT_DURATION     ((uint32_t)CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_HARD_SHORT_TIME * 1000U)
+#define HARD_SHORT_COUNT        CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_HARD_SHORT_COUNT
+#define LOG_SIZE                CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_LOG_SIZE
+#define INRUSH_TIME             ((uint64_t)CONFIG_BCB_TRIP_CURVE_DEFAULT_REC_INRUSH_TIME * 1000U)
+#define LOG_LEVEL               CONFIG_BCB_TRIP_CURVE_DEFAULT_LOG_LEVEL
+// clang-format on
+
+LOG_MODULE_REGISTER(bcb_tc_def_rec);
+
+struct tc_def_rec_inrush {
+	struct bcb_msmnt_frames_callback callback;
+	bcb_tc_def_rec_attempt_t *attempt; /* Attempt the capture is recorded in */
+	uint64_t start; /* Elapsed time of closing */
+	uint64_t tail; /* Start of the second half of the window */
+	uint64_t end;
+	int32_t offset; /* Calibration of the low gain current channel */
+	int32_t cal_a;
+	uint32_t peak; /* Raw peaks, offset removed */
+	uint32_t tail_peak;
+	int index;
+	bool is_active;
+};
+
+struct tc_def_rec_data {
+	struct tc_def_rec_inrush inrush; /* Accessed from the DMA interrupt */
+	bcb_tc_def_rec_attempt_t attempts[LOG_SIZE];
+	uint8_t attempts_head;
+	uint8_t attempts_count;
+	bool is_attempt_pending;
+	uint8_t hard_short_count;
+	uint64_t budget_credit;
+	int64_t budget_time;
+};
+
+static struct tc_def_rec_data rec_data;
+
+static inline bcb_tc_def_rec_attempt_t *attempt_push(void)
+{
+	bcb_tc_def_rec_attempt_t *attempt;
+	unsigned int key;
+
+	key = irq_lock();
+
+	rec_data.attempts_head = (rec_data.attempts_head + 1) % LOG_SIZE;
+	if (rec_data.attempts_count < LOG_SIZE) {
+		rec_data.attempts_count++;
+	}
+
+	attempt = &rec_data.attempts[rec_data.attempts_head];
+	memset(attempt, 0, sizeof(bcb_tc_def_rec_attempt_t));
+	if (rec_data.inrush.attempt == attempt) {
+		/* The slot is reused, the old capture must not overwrite it. */
+		rec_data.inrush.attempt = NULL;
+	}
+
+	irq_unlock(key);
+
+	return attempt;
+}
+
+/* Must be called with interrupts locked. */
+static inline void inrush_update_attempt(void)
+{
+	struct tc_def_rec_inrush *inrush = &rec_data.inrush;
+
+	if (!inrush->attempt) {
+		return;
+	}
+
+	inrush->attempt->inrush_peak = (uint32_t)((uint64_t)inrush->peak * 1000U / inrush->cal_a);
+	inrush->attempt->inrush_tail =
+		(uint32_t)((uint64_t)inrush->tail_peak * 1000U / inrush->cal_a);
+}
+
+static void inrush_on_frames(const bcb_msmnt_frames_t *frames)
+{
+	struct tc_def_rec_inrush *inrush = &rec_data.inrush;
+	const volatile uint16_t *sample;
+	uint64_t etime;
+	uint32_t value;
+	int32_t raw;
+	uint32_t i;
+
+	if (!inrush->is_active) {
+		return;
+	}
+
+	sample = frames->buffer + inrush->index;
+	etime = frames->etime - (uint64_t)(frames->count - 1) * frames->interval;
+
+	for (i = 0; i < frames->count; i++, sample += frames->stride, etime += frames->interval) {
+		if (etime < inrush->start) {
+			continue;
+		}
+
+		if (etime > inrush->end) {
+			inrush->is_active = false;
+			break;
+		}
+
+		raw = (int32_t)*sample - inrush->offset;
+		value = (uint32_t)(raw < 0 ? -raw : raw);
+		inrush->peak = MAX(inrush->peak, value);
+		if (etime >= inrush->tail) {
+			inrush->tail_peak = MAX(inrush->tail_peak, value);
+		}
+	}
+
+	inrush_update_attempt();
+}
+
+static inline bool budget_take(void)
+{
+	int64_t now;
+	uint64_t credit_max;
+
+	if (!BUDGET) {
+		return true;
+	}
+
+	/* Token bucket refilled with BUDGET attempts per hour. Credit is kept in milliseconds
+	 * times attempts to avoid rounding errors.
+	 */
+	now = k_uptime_get();
+	credit_max = (uint64_t)BUDGET * BUDGET_PERIOD;
+	rec_data.budget_credit += (uint64_t)(now - rec_data.budget_time) * BUDGET;
+	rec_data.budget_time = now;
+	if (rec_data.budget_credit > credit_max) {
+		rec_data.budget_credit = credit_max;
+	}
+
+	if (rec_data.budget_credit < BUDGET_PERIOD) {
+		return false;
+	}
+
+	rec_data.budget_credit -= BUDGET_PERIOD;
+	return true;
+}
+
+static inline uint32_t get_backoff_delay(uint32_t base, uint16_t attempt)
+{
+	uint64_t delay;
+	uint32_t jitter;
+
+	delay = attempt < 32 ? (uint64_t)base << attempt : BACKOFF_MAX;
+	if (delay > BACKOFF_MAX) {
+		delay = BACKOFF_MAX;
+	}
+
+	/* Jitter avoids breakers on the same feeder re-closing in lock-step. */
+	jitter = (uint32_t)(delay * BACKOFF_JITTER / 100U);
+	if (jitter) {
+		delay = delay - jitter + (sys_rand32_get() % (2U * jitter + 1U));
+	}
+
+	return delay > UINT32_MAX ? UINT32_MAX : (uint32_t)delay;
+}
+
+int bcb_tc_def_rec_init(void)
+{
+	memset(&rec_data, 0, sizeof(rec_data));
+	rec_data.budget_credit = (uint64_t)BUDGET * BUDGET_PERIOD;
+	rec_data.budget_time = k_uptime_get();
+
+	return 0;
+}
+
+void bcb_tc_def_rec_reset(void)
+{
+	rec_data.hard_short_count = 0;
+	rec_data.is_attempt_pending = false;
+}
+
+void bcb_tc_def_rec_on_close(void)
+{
+	struct tc_def_rec_inrush *inrush = &rec_data.inrush;
+	uint16_t cal_a;
+	uint16_t cal_b;
+	unsigned int key;
+
+	/* The low gain channel does not saturate with the inrush. */
+	if (!inrush->callback.handler) {
+		inrush->index = bcb_msmnt_get_frame_index(BCB_MSMNT_TYPE_I_LOW_GAIN);
+		if (inrush->index < 0) {
+			LOG_ERR("current samples not available");
+			return;
+		}
+
+		inrush->callback.handler = inrush_on_frames;
+		bcb_msmnt_add_frames_callback(&inrush->callback);
+	}
+
+	bcb_msmnt_get_calib_param_a(BCB_MSMNT_TYPE_I_LOW_GAIN, &cal_a);
+	bcb_msmnt_get_calib_param_b(BCB_MSMNT_TYPE_I_LOW_GAIN, &cal_b);
+
+	key = irq_lock();
+	inrush->attempt = rec_data.is_attempt_pending ? &rec_data.attempts[rec_data.attempts_head] :
+							 NULL;
+	inrush->offset = (int32_t)cal_b;
+	inrush->cal_a = MAX(cal_a, 1);
+	inrush->peak = 0;
+	inrush->tail_peak = 0;
+	inrush->start = bcb_etime_get_now();
+	inrush->tail = inrush->start + bcb_etime_from_us(INRUSH_TIME / 2);
+	inrush->end = inrush->start + bcb_etime_from_us(INRUSH_TIME);
+	inrush->is_active = true;
+	irq_unlock(key);
+}
+
+void bcb_tc_def_rec_on_trip(uint32_t trip_duration)
+{
+	bcb_tc_def_rec_attempt_t *attempt;
+	unsigned int key;
+
+	if (rec_data.is_attempt_pending) {
+		attempt = &rec_data.attempts[rec_data.attempts_head];
+	} else {
+		/* Trip of a user requested close. */
+		attempt = attempt_push();
+		attempt->timestamp = k_uptime_get_32();
+		attempt->delay = 0;
+	}
+
+	attempt->trip_duration = trip_duration;
+	rec_data.is_attempt_pending = false;
+
+	/* Samples up to the trip may still be on the way. */
+	key = irq_lock();
+	if (rec_data.inrush.is_active) {
+		rec_data.inrush.attempt = attempt;
+		rec_data.inrush.end = MIN(rec_data.inrush.end, bcb_etime_get_now());
+		inrush_update_attempt();
+	}
+	irq_unlock(key);
+
+	if (trip_duration < HARD_SHORT_DURATION) {
+		if (rec_data.hard_short_count < UINT8_MAX) {
+			rec_data.hard_short_count++;
+		}
+	} else {
+		rec_data.hard_short_count = 0;
+	}
+
+	LOG_DBG("trip: %" PRIu32 " ns, hard short count %" PRIu8, trip_duration,
+		rec_data.hard_short_count);
+}
+
+int bcb_tc_def_rec_next(const bcb_tc_def_msm_config_t *config, uint16_t attempt,
+			uint32_t *delay)
+{
+	bcb_tc_def_rec_attempt_t *entry;
+
+	switch (config->rec_policy) {
+	case BCB_TC_DEF_MSM_REC_POLICY_BACKOFF: {
+		if (HARD_SHORT_COUNT && rec_data.hard_short_count >= HARD_SHORT_COUNT) {
+			LOG_WRN("hard short, giving up");
+			return -ECANCELED;
+		}
+
+		if (!budget_take()) {
+			LOG_WRN("recovery budget exhausted");
+			return -EDQUOT;
+		}
+
+		*delay = get_backoff_delay(config->rec_delay, attempt);
+	} break;
+	default: {
+		*delay = config->rec_delay;
+	} break;
+	}
+
+	entry = attempt_push();
+	entry->timestamp = k_uptime_get_32();
+	entry->delay = *delay;
+	entry->trip_duration = UINT32_MAX;
+	rec_data.is_attempt_pending = true;
+
+	return 0;
+}
+
+int bcb_tc_def_rec_get_attempt(uint8_t index, bcb_tc_def_rec_attempt_t *attempt)
+{
+	unsigned int key;
+
+	if (index >= rec_data.attempts_count) {
+		return -ENOENT;
+	}
+
+	key = irq_lock();
+	memcpy(attempt, &rec_data.attempts[(rec_data.attempts_head + LOG_SIZE - index) % LOG_SIZE],
+	       sizeof(bcb_tc_def_rec_attempt_t));
+	irq_unlock(key);
+
+	return 0;
+}
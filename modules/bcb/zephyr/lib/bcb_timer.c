@@ -0,0 +1,223 @@
+#include <lib/bcb_timer.h>
+#include <lib/bcb_etime.h>
+#include <lib/bcb_tbase.h>
+#include <device.h>
+#include <devicetree.h>
+#include <drivers/counter_ctd.h>
+#include <errno.h>
+
+#define LOG_LEVEL CONFIG_BCB_LIB_TIMER_LOG_LEVEL
+#include <logging/log.h>
+LOG_MODULE_REGISTER(bcb_timer);
+
+// clang-format off
+/* PIT channels 0 to 2 are used by the elapsed time timer. */
+#define TIMER_CHANNEL           3
+// clang-format on
+
+struct bcb_timer_data {
+	struct device *dev_cnt_ctd;
+	bcb_tbase_t etime_to_ticks;
+	sys_slist_t timer_list; /* Sorted by the expiry time */
+};
+
+static struct bcb_timer_data timer_data;
+
+static void on_timer_alarm(struct device *dev, uint8_t chan_id, void *user_data);
+
+/* Must be called with interrupts locked. */
+static void timer_program(void)
+{
+	struct ctd_alarm_cfg alarm_cfg = { .callback = on_timer_alarm, .user_data = NULL };
+	struct bcb_timer *head;
+	uint64_t now;
+	uint64_t ticks;
+
+	counter_ctd_stop(timer_data.dev_cnt_ctd, TIMER_CHANNEL);
+
+	head = SYS_SLIST_PEEK_HEAD_CONTAINER(&timer_data.timer_list, head, node);
+	if (!head) {
+		counter_ctd_cancel_alarm(timer_data.dev_cnt_ctd, TIMER_CHANNEL);
+		return;
+	}
+
+	now = bcb_etime_get_now();
+	ticks = head->expiry > now ? head->expiry - now : 0;
+	/* Longer delays are served in steps; the alarm just re-arms for the remaining time. */
+	ticks = MIN(ticks, UINT32_MAX);
+	ticks = bcb_tbase_convert(&timer_data.etime_to_ticks, ticks);
+	ticks = MAX(MIN(ticks, UINT32_MAX), 1);
+
+	/* PIT raises the interrupt when the count down reaches zero after the top value. */
+	counter_ctd_set_top_value(timer_data.dev_cnt_ctd, TIMER_CHANNEL, (uint32_t)ticks - 1);
+	counter_ctd_set_alarm(timer_data.dev_cnt_ctd, TIMER_CHANNEL, &alarm_cfg);
+	counter_ctd_start(timer_data.dev_cnt_ctd, TIMER_CHANNEL);
+}
+
+static void on_timer_alarm(struct device *dev, uint8_t chan_id, void *user_data)
+{
+	struct bcb_timer *timer;
+	unsigned int key;
+
+	while (true) {
+		key = irq_lock();
+		timer = SYS_SLIST_PEEK_HEAD_CONTAINER(&timer_data.timer_list, timer, node);
+		if (!timer || timer->expiry > bcb_etime_get_now()) {
+			timer_program();
+			irq_unlock(key);
+			break;
+		}
+
+		/* Taken off before the handler is called, so that it may restart the timer. */
+		sys_slist_get_not_empty(&timer_data.timer_list);
+		timer->is_active = false;
+		timer->is_pending = timer->is_work;
+		irq_unlock(key);
+
+		if (timer->is_work) {
+			k_work_submit(&timer->work);
+		} else {
+			timer->handler(timer);
+		}
+	}
+}
+
+static void on_timer_work(struct k_work *work)
+{
+	struct bcb_timer *timer = CONTAINER_OF(work, struct bcb_timer, work);
+	unsigned int key;
+	bool is_pending;
+
+	key = irq_lock();
+	is_pending = timer->is_pending;
+	timer->is_pending = false;
+	irq_unlock(key);
+
+	/* The timer may have been stopped or restarted after the work was submitted. */
+	if (is_pending) {
+		timer->handler(timer);
+	}
+}
+
+int bcb_timer_init(void)
+{
+	timer_data.dev_cnt_ctd = device_get_binding(DT_LABEL(DT_NODELABEL(pit0)));
+	if (timer_data.dev_cnt_ctd == NULL) {
+		LOG_ERR("Could not get counter_ctd device");
+		return -EINVAL;
+	}
+
+	bcb_tbase_init(&timer_data.etime_to_ticks, bcb_etime_get_frequency(),
+		       counter_ctd_get_frequency(timer_data.dev_cnt_ctd));
+	sys_slist_init(&timer_data.timer_list);
+
+	return 0;
+}
+
+void bcb_timer_setup(struct bcb_timer *timer, bcb_timer_handler_t handler, bool is_work)
+{
+	timer->handler = handler;
+	timer->is_work = is_work;
+	timer->is_active = false;
+	timer->is_pending = false;
+	k_work_init(&timer->work, on_timer_work);
+}
+
+/* Must be called with interrupts locked. */
+static void timer_insert(struct bcb_timer *timer, uint64_t etime)
+{
+	struct bcb_timer *iter;
+	struct bcb_timer *prev;
+	struct bcb_timer *head;
+
+	head = SYS_SLIST_PEEK_HEAD_CONTAINER(&timer_data.timer_list, head, node);
+
+	if (timer->is_active) {
+		sys_slist_find_and_remove(&timer_data.timer_list, &timer->node);
+	}
+
+	timer->expiry = etime;
+	timer->is_active = true;
+	timer->is_pending = false;
+
+	prev = NULL;
+	SYS_SLIST_FOR_EACH_CONTAINER (&timer_data.timer_list, iter, node) {
+		if (iter->expiry > etime) {
+			break;
+		}
+		prev = iter;
+	}
+	sys_slist_insert(&timer_data.timer_list, prev ? &prev->node : NULL, &timer->node);
+
+	if (head == timer || !prev) {
+		/* The earliest expiry has changed. */
+		timer_program();
+	}
+}
+
+int bcb_timer_start_at(struct bcb_timer *timer, uint64_t etime)
+{
+	unsigned int key;
+
+	if (!timer_data.dev_cnt_ctd) {
+		return -ENODEV;
+	}
+
+	key = irq_lock();
+
+	if (etime <= bcb_etime_get_now()) {
+		irq_unlock(key);
+		return -ETIME;
+	}
+
+	timer_insert(timer, etime);
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+int bcb_timer_start(struct bcb_timer *timer, uint64_t delay)
+{
+	unsigned int key;
+
+	if (!timer_data.dev_cnt_ctd) {
+		return -ENODEV;
+	}
+
+	key = irq_lock();
+	timer_insert(timer, bcb_etime_get_now() + MAX(bcb_etime_from_us(delay), 1));
+	irq_unlock(key);
+
+	return 0;
+}
+
+void bcb_timer_stop(struct bcb_timer *timer)
+{
+	struct bcb_timer *head;
+	unsigned int key;
+
+	key = irq_lock();
+
+	timer->is_pending = false;
+
+	if (!timer->is_active) {
+		irq_unlock(key);
+		return;
+	}
+
+	head = SYS_SLIST_PEEK_HEAD_CONTAINER(&timer_data.timer_list, head, node);
+	sys_slist_find_and_remove(&timer_data.timer_list, &timer->node);
+	timer->is_active = false;
+
+	if (head == timer) {
+		timer_program();
+	}
+
+	irq_unlock(key);
+}
+
+bool bcb_timer_is_active(struct bcb_timer *timer)
+{
+	return timer->is_active;
+}
@@ -1,9 +1,13 @@
 #include <lib/bcb_zd.h>
 #include <lib/bcb_macros.h>
+#include <lib/bcb_etime.h>
+#include <lib/bcb_tbase.h>
+#include <lib/bcb_msmnt.h>
 #include <device.h>
 #include <devicetree.h>
 #include <drivers/input_capture.h>
 #include <drivers/gpio.h>
+#include <sys/util.h>
 
 #define LOG_LEVEL LOG_LEVEL_DBG
 #include <logging/log.h>
@@ -12,36 +16,176 @@ LOG_MODULE_REGISTER(bcb_zd);
 #define BCB_IC_DEV(ch_name) (zd_data.dev_ic_##ch_name)
 #define BCB_GPIO_DEV(pin_name) (zd_data.dev_gpio_##pin_name)
 
+// clang-format off
+#define ZD_MAINS_FREQ_MIN	40
+#define ZD_MAINS_FREQ_MAX	70
+/* The PLL keeps the edge time and the half-period with 8 fractional bits. */
+#define ZD_PLL_FRAC		8
+#define ZD_PLL_KP		CONFIG_BCB_LIB_ZD_PLL_KP
+#define ZD_PLL_KI		CONFIG_BCB_LIB_ZD_PLL_KI
+#define ZD_PLL_LOCK_COUNT	CONFIG_BCB_LIB_ZD_PLL_LOCK_COUNT
+// clang-format on
+
+/* A frequency gain as large as the phase gain makes the loop oscillate. */
+BUILD_ASSERT(ZD_PLL_KI > ZD_PLL_KP, "PLL frequency gain shift must be larger than the phase one");
+
 struct zd_data {
 	struct device *dev_ic_zd_v_mains;
 	struct device *dev_gpio_zd_v_mains;
-	uint32_t zd_v_last_timestamp;
 	volatile uint32_t zd_v_pulse_ticks;
+	bool zd_v_is_last_low;
+	volatile uint32_t zd_v_glitch_count;
 	sys_slist_t zd_v_callback_list;
+	bcb_tbase_t ic_to_etime;
+	uint32_t freq_dividend; /* Input capture frequency * 500 >> freq_shift */
+	uint8_t freq_shift;
+	uint32_t half_period_min;
+	uint32_t half_period_max;
+	uint32_t half_period_debounce;
+	uint64_t zd_v_last_edge;
+	uint64_t zd_v_predicted_edge;
+	volatile int32_t zd_v_prediction_error;
+	uint64_t pll_edge;
+	uint32_t pll_half_period;
+	bool pll_is_rising;
+	uint32_t pll_lock_threshold;
+	uint8_t pll_lock_count;
+	volatile bool pll_is_locked;
+	sys_slist_t zd_i_callback_list;
+	struct bcb_msmnt_frames_callback zd_i_frames_callback;
+	bool zd_i_enabled;
+	int zd_i_index;
+	int32_t zd_i_offset;
+	int32_t zd_i_hysteresis;
+	int8_t zd_i_polarity;
+	int32_t zd_i_last_sample;
+	uint64_t zd_i_last_sample_etime;
+	uint64_t zd_i_candidate;
+	volatile uint64_t zd_i_last_edge;
 };
 
 static struct zd_data zd_data;
 
+/**
+ * @brief Get the elapsed time at which the last zero-crossing edge has been captured.
+ *
+ * The input capture latches the edge in hardware. Hence, the interrupt latency is removed by
+ * going back from the current elapsed time by the number of ticks counted since the capture.
+ *
+ * @param dev		Input capture device
+ * @param channel	Base channel of the dual-edge capture
+ * @param is_falling	True if the last edge was a falling edge
+ * @return uint64_t	Elapsed time ticks
+ */
+static inline uint64_t get_edge_etime(struct device *dev, uint8_t channel, bool is_falling)
+{
+	uint64_t etime_now = bcb_etime_get_now();
+	uint32_t ic_now = input_capture_get_counter(dev);
+	/* In dual-edge pulse mode, the falling edge is latched by the next channel. */
+	uint32_t ic_edge = input_capture_get_edge_value(dev, is_falling ? channel + 1 : channel);
+	uint32_t ic_latency = ic_edge > ic_now ?
+				      input_capture_get_counter_maximum(dev) - ic_edge + ic_now :
+				      ic_now - ic_edge;
+
+	return etime_now - bcb_tbase_convert(&zd_data.ic_to_etime, ic_latency);
+}
+
+static inline void zd_v_pll_reset(void)
+{
+	zd_data.pll_half_period = 0;
+	zd_data.pll_lock_count = 0;
+	zd_data.pll_is_locked = false;
+}
+
+/**
+ * @brief Update the mains PLL with a captured zero-crossing edge.
+ *
+ * The PLL predicts the edge one half-period after its previous one. The prediction error
+ * corrects the phase (proportional) and the half-period (integral) of the PLL.
+ */
+static void zd_v_pll_update(uint64_t edge, uint32_t half_period, bool is_rising)
+{
+	uint64_t edge_frac = edge << ZD_PLL_FRAC;
+	int64_t error;
+	uint32_t error_abs;
+
+	if (!zd_data.pll_half_period) {
+		/* Start from the measured half-period. */
+		zd_data.pll_edge = edge_frac;
+		zd_data.pll_half_period = half_period << ZD_PLL_FRAC;
+		zd_data.pll_is_rising = is_rising;
+		return;
+	}
+
+	error = (int64_t)(edge_frac - (zd_data.pll_edge + zd_data.pll_half_period));
+	zd_data.pll_edge += zd_data.pll_half_period + (error >> ZD_PLL_KP);
+	zd_data.pll_half_period += (int32_t)(error >> ZD_PLL_KI);
+	zd_data.pll_half_period = MAX(MIN(zd_data.pll_half_period,
+					  zd_data.half_period_max << ZD_PLL_FRAC),
+				      zd_data.half_period_min << ZD_PLL_FRAC);
+	zd_data.pll_is_rising = is_rising;
+
+	error_abs = (uint32_t)MIN((error < 0 ? -error : error) >> ZD_PLL_FRAC, UINT32_MAX);
+	if (error_abs > zd_data.pll_lock_threshold) {
+		zd_data.pll_lock_count = 0;
+		zd_data.pll_is_locked = false;
+	} else if (zd_data.pll_lock_count < ZD_PLL_LOCK_COUNT) {
+		zd_data.pll_lock_count++;
+	} else {
+		zd_data.pll_is_locked = true;
+	}
+}
+
+static void zd_v_track(uint64_t edge, bool is_rising)
+{
+	uint32_t half_period = (uint32_t)MIN(edge - zd_data.zd_v_last_edge, UINT32_MAX);
+
+	zd_data.zd_v_last_edge = edge;
+
+	if (zd_data.zd_v_predicted_edge) {
+		int64_t error = (int64_t)(edge - zd_data.zd_v_predicted_edge);
+		int64_t error_ns = (int64_t)bcb_etime_to_ns(error < 0 ? -error : error);
+		error_ns = MIN(error_ns, INT32_MAX);
+		zd_data.zd_v_prediction_error = (int32_t)(error < 0 ? -error_ns : error_ns);
+		zd_data.zd_v_predicted_edge = 0;
+	}
+
+	if (half_period < zd_data.half_period_min || half_period > zd_data.half_period_max) {
+		/* Mains is either not present or too distorted to be tracked. */
+		zd_v_pll_reset();
+		return;
+	}
+
+	zd_v_pll_update(edge, half_period, is_rising);
+}
+
 static void zd_v_mains_callback(struct device *dev, uint8_t channel, uint8_t edge)
 {
 	bool is_zd_low = BCB_GPIO_PIN_GET_RAW(dctrl, zd_v_mains) == 0;
-	uint32_t now = k_uptime_get_32();
-	uint32_t pulse_duration;
+	uint64_t edge_etime = get_edge_etime(dev, channel, is_zd_low);
+	uint64_t elapsed = edge_etime - zd_data.zd_v_last_edge;
 	sys_snode_t *node;
 
-	pulse_duration = zd_data.zd_v_last_timestamp > now ?
-				 UINT32_MAX - zd_data.zd_v_last_timestamp + now :
-				 now - zd_data.zd_v_last_timestamp;
-	zd_data.zd_v_last_timestamp = now;
+	/* Debouncing is done on the captured edge times, relative to the last accepted edge. */
+	if (elapsed < zd_data.half_period_debounce) {
+		zd_data.zd_v_glitch_count++;
+		return;
+	}
 
-	if (pulse_duration < 5) {
+	if (is_zd_low == zd_data.zd_v_is_last_low && elapsed <= zd_data.half_period_max) {
+		/* Accepted edges alternate. The opposite edge of this one has been rejected. */
+		zd_data.zd_v_glitch_count++;
 		return;
 	}
 
+	zd_data.zd_v_is_last_low = is_zd_low;
+
 	if (is_zd_low) {
 		zd_data.zd_v_pulse_ticks = input_capture_get_value(dev, channel);
 	}
 
+	zd_v_track(edge_etime, !is_zd_low);
+
 	SYS_SLIST_FOR_EACH_NODE (&zd_data.zd_v_callback_list, node) {
 		struct bcb_zd_callback *callback = (struct bcb_zd_callback *)node;
 		if (callback && callback->handler) {
@@ -50,10 +194,105 @@ static void zd_v_mains_callback(struct device *dev, uint8_t channel, uint8_t edg
 	}
 }
 
+static void zd_i_call_callbacks(void)
+{
+	sys_snode_t *node;
+
+	SYS_SLIST_FOR_EACH_NODE (&zd_data.zd_i_callback_list, node) {
+		struct bcb_zd_callback *callback = (struct bcb_zd_callback *)node;
+		if (callback && callback->handler) {
+			callback->handler();
+		}
+	}
+}
+
+/**
+ * @brief Detect the current zero-crossings in the sample stream.
+ *
+ * A crossing is accepted only after the current passed the hysteresis band in the opposite
+ * polarity. Its time is linearly interpolated between the two samples around the sign change.
+ */
+static void zd_i_on_frames(const bcb_msmnt_frames_t *frames)
+{
+	const volatile uint16_t *sample = frames->buffer + zd_data.zd_i_index;
+	uint64_t etime = frames->etime - (uint64_t)(frames->count - 1) * frames->interval;
+	uint32_t i;
+
+	for (i = 0; i < frames->count; i++, sample += frames->stride, etime += frames->interval) {
+		int32_t value = (int32_t)*sample - zd_data.zd_i_offset;
+		int32_t last = zd_data.zd_i_last_sample;
+		int8_t polarity = zd_data.zd_i_polarity;
+
+		if ((last < 0) != (value < 0)) {
+			uint32_t last_abs = (uint32_t)(last < 0 ? -last : last);
+			uint32_t value_abs = (uint32_t)(value < 0 ? -value : value);
+
+			zd_data.zd_i_candidate = zd_data.zd_i_last_sample_etime +
+						 (uint64_t)frames->interval * last_abs /
+							 (last_abs + value_abs);
+		}
+
+		if (value >= zd_data.zd_i_hysteresis) {
+			polarity = 1;
+		} else if (value <= -zd_data.zd_i_hysteresis) {
+			polarity = -1;
+		}
+
+		if (zd_data.zd_i_polarity && polarity != zd_data.zd_i_polarity) {
+			zd_data.zd_i_last_edge = zd_data.zd_i_candidate;
+			zd_i_call_callbacks();
+		}
+
+		zd_data.zd_i_polarity = polarity;
+		zd_data.zd_i_last_sample = value;
+		zd_data.zd_i_last_sample_etime = etime;
+	}
+}
+
+static void zd_i_set_enable(bool enable)
+{
+	uint16_t cal_a;
+	uint16_t cal_b;
+
+	if (enable == zd_data.zd_i_enabled) {
+		return;
+	}
+
+	if (!enable) {
+		bcb_msmnt_remove_frames_callback(&zd_data.zd_i_frames_callback);
+		zd_data.zd_i_enabled = false;
+		return;
+	}
+
+	/* The high gain channel has the best resolution around zero. It does not matter even
+	 * if the channel gets saturated at the peaks.
+	 */
+	zd_data.zd_i_index = bcb_msmnt_get_frame_index(BCB_MSMNT_TYPE_I_HIGH_GAIN);
+	if (zd_data.zd_i_index < 0) {
+		LOG_ERR("current samples not available");
+		return;
+	}
+
+	bcb_msmnt_get_calib_param_a(BCB_MSMNT_TYPE_I_HIGH_GAIN, &cal_a);
+	bcb_msmnt_get_calib_param_b(BCB_MSMNT_TYPE_I_HIGH_GAIN, &cal_b);
+	zd_data.zd_i_offset = (int32_t)cal_b;
+	zd_data.zd_i_hysteresis = CONFIG_BCB_LIB_ZD_CURRENT_HYSTERESIS * (int32_t)cal_a / 1000;
+	zd_data.zd_i_polarity = 0;
+	zd_data.zd_i_last_sample = 0;
+	zd_data.zd_i_last_edge = 0;
+
+	zd_data.zd_i_frames_callback.handler = zd_i_on_frames;
+	bcb_msmnt_add_frames_callback(&zd_data.zd_i_frames_callback);
+	zd_data.zd_i_enabled = true;
+}
+
 int bcb_zd_init(void)
 {
+	uint64_t ic_frequency_500;
+
 	memset(&zd_data, 0, sizeof(zd_data));
 	sys_slist_init(&zd_data.zd_v_callback_list);
+	sys_slist_init(&zd_data.zd_i_callback_list);
 
 	BCB_IC_INIT(itimestamp, zd_v_mains);
 	BCB_IC_CHANNEL_SET(itimestamp, zd_v_mains);
@@ -66,17 +305,146 @@ int bcb_zd_init(void)
 	BCB_GPIO_PIN_INIT(dctrl, zd_v_mains);
 	BCB_GPIO_PIN_CONFIG(dctrl, zd_v_mains, GPIO_INPUT);
 
+	bcb_tbase_init(&zd_data.ic_to_etime,
+		       input_capture_get_frequency(zd_data.dev_ic_zd_v_mains),
+		       bcb_etime_get_frequency());
+	ic_frequency_500 = (uint64_t)input_capture_get_frequency(zd_data.dev_ic_zd_v_mains) * 500U;
+	zd_data.freq_shift = 0;
+	while ((ic_frequency_500 >> zd_data.freq_shift) > UINT32_MAX) {
+		zd_data.freq_shift++;
+	}
+	zd_data.freq_dividend = (uint32_t)(ic_frequency_500 >> zd_data.freq_shift);
+	zd_data.half_period_min = bcb_etime_get_frequency() / (2 * ZD_MAINS_FREQ_MAX);
+	zd_data.half_period_max = bcb_etime_get_frequency() / (2 * ZD_MAINS_FREQ_MIN);
+	zd_data.half_period_debounce = (uint32_t)bcb_etime_from_us(CONFIG_BCB_LIB_ZD_DEBOUNCE);
+	zd_data.pll_lock_threshold =
+		(uint32_t)bcb_etime_from_us(CONFIG_BCB_LIB_ZD_PLL_LOCK_THRESHOLD);
+
 	return 0;
 }
 
 uint32_t bcb_zd_get_frequency(void)
 {
-	if (!zd_data.zd_v_pulse_ticks) {
+	uint32_t pulse_ticks = zd_data.zd_v_pulse_ticks;
+	uint32_t round = zd_data.freq_shift ? 1U << (zd_data.freq_shift - 1) : 0;
+	uint32_t divisor;
+
+	/* Pulse width is half of the period. Frequency is in mHz.
+	 * Both sides are scaled down alike so that a 32-bit divide is enough.
+	 */
+	divisor = (uint32_t)(((uint64_t)pulse_ticks + round) >> zd_data.freq_shift);
+	if (!divisor) {
 		return 0;
 	}
 
-	return input_capture_get_frequency(zd_data.dev_ic_zd_v_mains) * 500 /
-	       zd_data.zd_v_pulse_ticks;
+	return zd_data.freq_dividend / divisor;
+}
+
+uint32_t bcb_zd_get_half_period(void)
+{
+	uint32_t half_period;
+	unsigned int key = irq_lock();
+
+	half_period = zd_data.pll_is_locked ? zd_data.pll_half_period >> ZD_PLL_FRAC : 0;
+
+	irq_unlock(key);
+
+	return half_period;
+}
+
+uint32_t bcb_zd_get_period(void)
+{
+	return 2 * bcb_zd_get_half_period();
+}
+
+bool bcb_zd_is_locked(void)
+{
+	return zd_data.pll_is_locked;
+}
+
+int bcb_zd_get_phase(uint64_t etime, uint16_t *phase)
+{
+	uint64_t edge;
+	uint32_t half_period;
+	bool is_rising;
+	int64_t elapsed;
+	unsigned int key;
+
+	if (!phase) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+
+	if (!zd_data.pll_is_locked) {
+		irq_unlock(key);
+		return -EAGAIN;
+	}
+
+	edge = zd_data.pll_edge;
+	half_period = zd_data.pll_half_period;
+	is_rising = zd_data.pll_is_rising;
+
+	irq_unlock(key);
+
+	elapsed = (int64_t)((etime << ZD_PLL_FRAC) - edge);
+	/* Wraps around modulo a full cycle. */
+	*phase = (uint16_t)(elapsed * 32768 / (int64_t)half_period + (is_rising ? 0 : 32768));
+
+	return 0;
+}
+
+int bcb_zd_get_next_crossing(bcb_zd_type_t type, uint64_t *etime)
+{
+	uint32_t half_period;
+	uint64_t predicted;
+	unsigned int key;
+
+	if (!etime) {
+		return -EINVAL;
+	}
+
+	/* Current has the same frequency as the voltage. */
+	half_period = bcb_zd_get_half_period();
+	if (!half_period) {
+		return -EAGAIN;
+	}
+
+	key = irq_lock();
+
+	if (type == BCB_ZD_TYPE_VOLTAGE) {
+		predicted = (zd_data.pll_edge + zd_data.pll_half_period) >> ZD_PLL_FRAC;
+	} else if (zd_data.zd_i_enabled && zd_data.zd_i_last_edge) {
+		predicted = zd_data.zd_i_last_edge + half_period;
+	} else {
+		irq_unlock(key);
+		return -EAGAIN;
+	}
+
+	if (predicted <= bcb_etime_get_now()) {
+		/* The last edge is older than a half-cycle (i.e. the caller has been delayed). */
+		predicted += half_period;
+	}
+
+	if (type == BCB_ZD_TYPE_VOLTAGE) {
+		zd_data.zd_v_predicted_edge = predicted;
+	}
+
+	irq_unlock(key);
+
+	*etime = predicted;
+
+	return 0;
+}
+
+uint32_t bcb_zd_get_glitch_count(void)
+{
+	return zd_data.zd_v_glitch_count;
+}
+
+int32_t bcb_zd_get_prediction_error(void)
+{
+	return zd_data.zd_v_prediction_error;
 }
 
 int bcb_zd_add_callback(bcb_zd_type_t type, struct bcb_zd_callback *callback)
@@ -87,6 +455,8 @@ int bcb_zd_add_callback(bcb_zd_type_t type, struct bcb_zd_callback *callback)
 
 	if (type == BCB_ZD_TYPE_VOLTAGE) {
 		sys_slist_append(&zd_data.zd_v_callback_list, &callback->node);
+	} else if (type == BCB_ZD_TYPE_CURRENT) {
+		sys_slist_append(&zd_data.zd_i_callback_list, &callback->node);
 	}
 
 	return 0;
@@ -100,6 +470,8 @@ void bcb_zd_remove_callback(bcb_zd_type_t type, struct bcb_zd_callback *callback
 
 	if (type == BCB_ZD_TYPE_VOLTAGE) {
 		sys_slist_find_and_remove(&zd_data.zd_v_callback_list, &callback->node);
+	} else if (type == BCB_ZD_TYPE_CURRENT) {
+		sys_slist_find_and_remove(&zd_data.zd_i_callback_list, &callback->node);
 	}
 }
 
@@ -108,5 +480,7 @@ void bcb_zd_set_enable(bcb_zd_type_t type, bool enable)
 	if (type == BCB_ZD_TYPE_VOLTAGE) {
 		input_capture_enable_interrupts(zd_data.dev_ic_zd_v_mains,
 						BCB_IC_CHANNEL(itimestamp, zd_v_mains), enable);
+	} else if (type == BCB_ZD_TYPE_CURRENT) {
+		zd_i_set_enable(enable);
 	}
 }
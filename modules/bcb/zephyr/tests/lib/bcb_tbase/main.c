@@ -0,0 +1,130 @@
+#include <lib/bcb_tbase.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK_EQ(actual, expected, what)                                                           \
+	do {                                                                                       \
+		uint64_t _a = (actual);                                                            \
+		uint64_t _e = (expected);                                                          \
+		if (_a != _e) {                                                                    \
+			printf("FAIL %s:%d %s: %" PRIu64 " != %" PRIu64 "\n", __FILE__, __LINE__,  \
+			       (what), _a, _e);                                                    \
+			failures++;                                                                \
+		}                                                                                  \
+	} while (0)
+
+/* Exact ticks * to / from rounded to the nearest. */
+static uint64_t convert_exact(uint64_t ticks, uint32_t from, uint32_t to)
+{
+	unsigned __int128 product = (unsigned __int128)ticks * to;
+
+	return (uint64_t)((product + from / 2) / from);
+}
+
+/*
+ * The multiplier keeps 64 significant bits, so besides the rounding half a unit the result may be
+ * off by up to 2^-64 of itself. Below 2^40 that can only flip the rounding of exact halves.
+ */
+static void check_convert(const bcb_tbase_t *tbase, uint64_t ticks, uint32_t from, uint32_t to,
+			  const char *what, int line)
+{
+	unsigned __int128 product = (unsigned __int128)ticks * to;
+	unsigned __int128 scaled;
+	unsigned __int128 diff;
+	uint64_t actual = bcb_tbase_convert(tbase, ticks);
+	uint64_t expected = convert_exact(ticks, from, to);
+
+	if (expected < (1ULL << 40)) {
+		bool half = (product % from) * 2 == from;
+
+		if (actual != expected && !(half && actual == expected - 1)) {
+			printf("FAIL line %d %s: ticks %" PRIu64 ": %" PRIu64 " != %" PRIu64 "\n",
+			       line, what, ticks, actual, expected);
+			failures++;
+		}
+		return;
+	}
+
+	scaled = (unsigned __int128)actual * from;
+	diff = scaled > product ? scaled - product : product - scaled;
+	if (diff > from / 2 + (product >> 64) + 1) {
+		printf("FAIL line %d %s: ticks %" PRIu64 ": %" PRIu64 " too far from %" PRIu64 "\n",
+		       line, what, ticks, actual, expected);
+		failures++;
+	}
+}
+
+static void check_range(uint32_t from, uint32_t to, uint64_t max_ticks)
+{
+	static const uint64_t fixed[] = { 0, 1, 2, 3, 999, 1000, 1001, 29999, 30000, 1ULL << 27,
+					  (1ULL << 32) - 1, 1ULL << 32, (1ULL << 32) + 1 };
+	bcb_tbase_t tbase;
+	uint64_t ticks;
+	uint64_t lcg = 0x2545F4914F6CDD1DULL;
+	char what[64];
+	size_t i;
+
+	CHECK_EQ(bcb_tbase_init(&tbase, from, to), 0, "init");
+	snprintf(what, sizeof(what), "%" PRIu32 " -> %" PRIu32, from, to);
+
+	for (i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+		if (fixed[i] <= max_ticks) {
+			check_convert(&tbase, fixed[i], from, to, what, __LINE__);
+		}
+	}
+
+	/* Powers of two and their neighbours up to the limit. */
+	for (ticks = 1; ticks && ticks <= max_ticks / 2; ticks <<= 1) {
+		check_convert(&tbase, ticks, from, to, what, __LINE__);
+		check_convert(&tbase, ticks - 1, from, to, what, __LINE__);
+		check_convert(&tbase, ticks + 1, from, to, what, __LINE__);
+	}
+
+	for (i = 0; i < 100000; i++) {
+		lcg = lcg * 6364136223846793005ULL + 1442695040888963407ULL;
+		ticks = lcg >> (lcg % 64);
+		if (max_ticks != UINT64_MAX) {
+			ticks %= max_ticks + 1;
+		}
+		check_convert(&tbase, ticks, from, to, what, __LINE__);
+	}
+}
+
+int main(void)
+{
+	const uint64_t day_ns = 86400ULL * 1000000000ULL;
+	bcb_tbase_t tbase;
+
+	CHECK_EQ(bcb_tbase_init(&tbase, 0, 1000), (uint64_t)-EINVAL, "zero from");
+	CHECK_EQ(bcb_tbase_init(&tbase, 1000, 0), (uint64_t)-EINVAL, "zero to");
+
+	/* Cases found in review: 30 MHz elapsed time ticks to and from ns. */
+	bcb_tbase_init(&tbase, 30000000, 1000000000);
+	CHECK_EQ(bcb_tbase_convert(&tbase, 86400ULL * 30000000ULL), day_ns, "one day to ns");
+	CHECK_EQ(bcb_tbase_convert(&tbase, 1ULL << 32), 143165576533ULL, "2^32 ticks to ns");
+	bcb_tbase_init(&tbase, 1000000000, 30000000);
+	CHECK_EQ(bcb_tbase_convert(&tbase, day_ns), 86400ULL * 30000000ULL, "one day from ns");
+
+	/* Results are kept below 2^63 so that the checks cannot overflow. */
+	check_range(30000000, 1000000000, (1ULL << 63) / 34);
+	check_range(1000000000, 30000000, UINT64_MAX);
+	check_range(1000000, 30000000, (1ULL << 63) / 30);
+	check_range(60000000, 30000000, UINT64_MAX);
+	check_range(30000000, 60000000, (1ULL << 62));
+	check_range(32768, 1000000000, (1ULL << 63) / 30518);
+	check_range(1, UINT32_MAX, (1ULL << 63) / UINT32_MAX);
+	check_range(UINT32_MAX, 1, UINT64_MAX);
+	check_range(7, 3, UINT64_MAX);
+
+	if (failures) {
+		printf("%d failures\n", failures);
+		return 1;
+	}
+
+	printf("all passed\n");
+	return 0;
+}